@@ -1,10 +1,19 @@
 #based on: https://github.com/DomiStyle/esphome-panasonic-ac
 from esphome.const import (
     CONF_ID,
+    CONF_PLATFORM,
+    CONF_TIME_ID,
+    ENTITY_CATEGORY_DIAGNOSTIC,
+    STATE_CLASS_MEASUREMENT,
+    STATE_CLASS_TOTAL_INCREASING,
+    UNIT_BYTES,
+    UNIT_MICROSECOND,
+    UNIT_MILLISECOND,
 )
 import esphome.codegen as cg
 import esphome.config_validation as cv
-from esphome.components import uart, climate, sensor, select, switch
+import esphome.final_validate as fv
+from esphome.components import uart, climate, sensor, select, switch, time
 
 AUTO_LOAD = ["switch", "sensor", "select"]
 DEPENDENCIES = ["uart"]
@@ -36,6 +45,42 @@ CONF_XFAN_SWITCH                = "xfan_switch"
 CONF_SAVE_SWITCH                = "save_switch"
 
 CONF_CURRENT_TEMPERATURE_SENSOR = "current_temperature_sensor"
+CONF_CURRENT_TEMPERATURE_HYSTERESIS = "current_temperature_hysteresis"
+CONF_CURRENT_TEMPERATURE_SMOOTHING = "current_temperature_smoothing"
+
+CONF_COMMAND_LATENCY_P50        = "command_latency_p50"
+CONF_COMMAND_LATENCY_P95        = "command_latency_p95"
+CONF_COMMAND_LATENCY_MAX        = "command_latency_max"
+CONF_COMMAND_RETRIES            = "command_retries"
+
+CONF_RX_FRAMES_UNIT_REPORT      = "rx_frames_unit_report"
+CONF_RX_FRAMES_0X33             = "rx_frames_0x33"
+CONF_RX_FRAMES_0X44             = "rx_frames_0x44"
+CONF_RX_FRAMES_OTHER            = "rx_frames_other"
+CONF_CHECKSUM_ERRORS            = "checksum_errors"
+CONF_OVERFLOW_DROPS             = "overflow_drops"
+CONF_RESYNC_EVENTS              = "resync_events"
+CONF_FRAME_TIMEOUTS             = "frame_timeouts"
+CONF_LOOP_BYTES_MAX             = "loop_bytes_max"
+CONF_LOOP_TIME_MAX              = "loop_time_max"
+CONF_LOOP_TIME_TOTAL            = "loop_time_total"
+CONF_FIRST_PUBLISH_TIME         = "first_publish_time"
+CONF_PUBLISHES_EMITTED          = "publishes_emitted"
+CONF_PUBLISHES_SUPPRESSED       = "publishes_suppressed"
+CONF_LINK_READY_TIME            = "link_ready_time"
+CONF_FIRST_COMMAND_TIME         = "first_command_time"
+CONF_FREE_HEAP_MIN              = "free_heap_min"
+CONF_RX_BACKLOG_BYTES_MAX       = "rx_backlog_bytes_max"
+CONF_RX_BACKLOG_FRAMES_MAX      = "rx_backlog_frames_max"
+
+CONF_GROUP                      = "group"
+CONF_FOLLOW_ME                  = "follow_me"
+CONF_KP                         = "kp"
+CONF_KI                         = "ki"
+CONF_SCHEDULE                   = "schedule"
+
+CONF_LOOP_BUDGET                = "loop_budget"
+CONF_FRAME_TRACE_SIZE           = "frame_trace_size"
 
 HORIZONTAL_SWING_OPTIONS = [
     "0 - OFF",
@@ -83,6 +128,67 @@ select_schema = select.select_schema(select.Select).extend(
     {cv.GenerateID(CONF_ID): cv.declare_id(SinclairACSelect)}
 )
 
+latency_sensor_schema = sensor.sensor_schema(
+    unit_of_measurement=UNIT_MILLISECOND,
+    icon="mdi:timer-outline",
+    accuracy_decimals=0,
+    state_class=STATE_CLASS_MEASUREMENT,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+)
+counter_sensor_schema = sensor.sensor_schema(
+    icon="mdi:counter",
+    accuracy_decimals=0,
+    state_class=STATE_CLASS_TOTAL_INCREASING,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+)
+
+bytes_sensor_schema = sensor.sensor_schema(
+    unit_of_measurement=UNIT_BYTES,
+    icon="mdi:memory",
+    accuracy_decimals=0,
+    state_class=STATE_CLASS_MEASUREMENT,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+)
+backlog_frames_sensor_schema = sensor.sensor_schema(
+    icon="mdi:tray-full",
+    accuracy_decimals=0,
+    state_class=STATE_CLASS_MEASUREMENT,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+)
+loop_time_sensor_schema = sensor.sensor_schema(
+    unit_of_measurement=UNIT_MICROSECOND,
+    icon="mdi:timer-outline",
+    accuracy_decimals=0,
+    state_class=STATE_CLASS_MEASUREMENT,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+)
+
+DIAGNOSTIC_SENSORS = {
+    CONF_COMMAND_LATENCY_P50: latency_sensor_schema,
+    CONF_COMMAND_LATENCY_P95: latency_sensor_schema,
+    CONF_COMMAND_LATENCY_MAX: latency_sensor_schema,
+    CONF_COMMAND_RETRIES: counter_sensor_schema,
+    CONF_RX_FRAMES_UNIT_REPORT: counter_sensor_schema,
+    CONF_RX_FRAMES_0X33: counter_sensor_schema,
+    CONF_RX_FRAMES_0X44: counter_sensor_schema,
+    CONF_RX_FRAMES_OTHER: counter_sensor_schema,
+    CONF_CHECKSUM_ERRORS: counter_sensor_schema,
+    CONF_OVERFLOW_DROPS: counter_sensor_schema,
+    CONF_RESYNC_EVENTS: counter_sensor_schema,
+    CONF_FRAME_TIMEOUTS: counter_sensor_schema,
+    CONF_LOOP_BYTES_MAX: bytes_sensor_schema,
+    CONF_LOOP_TIME_MAX: loop_time_sensor_schema,
+    CONF_LOOP_TIME_TOTAL: loop_time_sensor_schema,
+    CONF_FIRST_PUBLISH_TIME: latency_sensor_schema,
+    CONF_PUBLISHES_EMITTED: counter_sensor_schema,
+    CONF_PUBLISHES_SUPPRESSED: counter_sensor_schema,
+    CONF_LINK_READY_TIME: latency_sensor_schema,
+    CONF_FIRST_COMMAND_TIME: latency_sensor_schema,
+    CONF_FREE_HEAP_MIN: bytes_sensor_schema,
+    CONF_RX_BACKLOG_BYTES_MAX: bytes_sensor_schema,
+    CONF_RX_BACKLOG_FRAMES_MAX: backlog_frames_sensor_schema,
+}
+
 SCHEMA = climate.climate_schema(climate.Climate).extend(
     {
         cv.Optional(CONF_HORIZONTAL_SWING_SELECT): select_schema,
@@ -94,18 +200,87 @@ SCHEMA = climate.climate_schema(climate.Climate).extend(
         cv.Optional(CONF_SLEEP_SWITCH): switch_schema,
         cv.Optional(CONF_XFAN_SWITCH): switch_schema,
         cv.Optional(CONF_SAVE_SWITCH): switch_schema,
+        **{cv.Optional(key): schema for key, schema in DIAGNOSTIC_SENSORS.items()},
     }
 ).extend(uart.UART_DEVICE_SCHEMA)
 
+def validate_group(config):
+    if config[CONF_ID] in config.get(CONF_GROUP, []):
+        raise cv.Invalid("A unit cannot be a member of its own group")
+    members = [member.id for member in config.get(CONF_GROUP, [])]
+    for member in members:
+        if members.count(member) > 1:
+            raise cv.Invalid(f"{member} is listed twice in the group", path=[CONF_GROUP])
+    return config
+
+
+def final_validate_groups(config):
+    """A unit takes commands from one leader only, and a member does not lead a group of its own"""
+    units = [
+        conf for conf in fv.full_config.get().get("climate", [])
+        if conf.get(CONF_PLATFORM) == "sinclair_ac"
+    ]
+    own_id = config[CONF_ID].id
+    members = {member.id for member in config.get(CONF_GROUP, [])}
+    for other in units:
+        other_id = other[CONF_ID].id
+        if other_id == own_id:
+            continue
+        other_members = {member.id for member in other.get(CONF_GROUP, [])}
+        shared = sorted(members & other_members)
+        if shared:
+            raise cv.Invalid(
+                f"{shared[0]} is in the groups of both {own_id} and {other_id}, a unit can be in one group only",
+                path=[CONF_GROUP],
+            )
+        if members and own_id in other_members:
+            raise cv.Invalid(
+                f"{own_id} leads a group and is a member of the group of {other_id}, groups cannot be nested",
+                path=[CONF_GROUP],
+            )
+    return config
+
+
+def validate_follow_me(config):
+    if CONF_FOLLOW_ME in config and CONF_CURRENT_TEMPERATURE_SENSOR not in config:
+        raise cv.Invalid(f"{CONF_FOLLOW_ME} needs {CONF_CURRENT_TEMPERATURE_SENSOR}")
+    return config
+
+
+FOLLOW_ME_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_KP, default=2.0): cv.float_range(min=0.0, max=10.0),
+        cv.Optional(CONF_KI, default=0.1): cv.float_range(min=0.0, max=10.0),
+    }
+)
+
+SCHEDULE_SCHEMA = cv.Schema(
+    {
+        cv.Required(CONF_TIME_ID): cv.use_id(time.RealTimeClock),
+    }
+)
+
+
 CONFIG_SCHEMA = cv.All(
     SCHEMA.extend(
         {
             cv.GenerateID(): cv.declare_id(SinclairACCNT),
             cv.Optional(CONF_CURRENT_TEMPERATURE_SENSOR): cv.use_id(sensor.Sensor),
+            cv.Optional(CONF_CURRENT_TEMPERATURE_HYSTERESIS, default=0.0): cv.float_range(min=0.0),
+            cv.Optional(CONF_CURRENT_TEMPERATURE_SMOOTHING, default=2): cv.int_range(min=0, max=4),
+            cv.Optional(CONF_LOOP_BUDGET, default="2ms"): cv.positive_time_period_microseconds,
+            cv.Optional(CONF_FRAME_TRACE_SIZE, default=0): cv.int_range(min=0, max=16384),
+            cv.Optional(CONF_GROUP): cv.ensure_list(cv.use_id(SinclairACCNT)),
+            cv.Optional(CONF_FOLLOW_ME): FOLLOW_ME_SCHEMA,
+            cv.Optional(CONF_SCHEDULE): SCHEDULE_SCHEMA,
         }
     ),
+    validate_group,
+    validate_follow_me,
 )
 
+FINAL_VALIDATE_SCHEMA = final_validate_groups
+
 
 async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
@@ -140,7 +315,23 @@ async def to_code(config):
     if CONF_CURRENT_TEMPERATURE_SENSOR in config:
         sens = await cg.get_variable(config[CONF_CURRENT_TEMPERATURE_SENSOR])
         cg.add(var.set_current_temperature_sensor(sens))
+    if CONF_FOLLOW_ME in config:
+        conf = config[CONF_FOLLOW_ME]
+        cg.add(var.set_follow_me(conf[CONF_KP], conf[CONF_KI]))
+    if CONF_SCHEDULE in config:
+        clock = await cg.get_variable(config[CONF_SCHEDULE][CONF_TIME_ID])
+        cg.add(var.set_schedule_clock(clock))
+
+    cg.add(var.set_current_temperature_hysteresis(config[CONF_CURRENT_TEMPERATURE_HYSTERESIS]))
+    cg.add(var.set_current_temperature_smoothing(config[CONF_CURRENT_TEMPERATURE_SMOOTHING]))
+    cg.add(var.set_loop_budget(config[CONF_LOOP_BUDGET].total_microseconds))
+    if config[CONF_FRAME_TRACE_SIZE] > 0:
+        cg.add(var.set_frame_trace_size(config[CONF_FRAME_TRACE_SIZE]))
         
+    for member_id in config.get(CONF_GROUP, []):
+        member = await cg.get_variable(member_id)
+        cg.add(var.add_group_member(member))
+
     for s in [CONF_PLASMA_SWITCH, CONF_BEEPER_SWITCH, CONF_SLEEP_SWITCH, CONF_XFAN_SWITCH, CONF_SAVE_SWITCH]:
         if s in config:
             conf = config[s]
@@ -148,3 +339,8 @@ async def to_code(config):
             await cg.register_component(a_switch, conf)
             await switch.register_switch(a_switch, conf)
             cg.add(getattr(var, f"set_{s}")(a_switch))
+
+    for s in DIAGNOSTIC_SENSORS:
+        if s in config:
+            a_sensor = await sensor.new_sensor(config[s])
+            cg.add(getattr(var, f"set_{s}_sensor")(a_sensor))
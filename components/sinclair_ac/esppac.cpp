@@ -1,15 +1,51 @@
 #include "esppac.h"
 #include "esphome/core/log.h"
+#include <cinttypes>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef USE_ESP8266
+#include <Esp.h>
+#endif
+#ifdef USE_ESP32
+#include <esp_heap_caps.h>
+#endif
 
 namespace esphome {
 namespace sinclair_ac {
 
 static const char *const TAG = "sinclair_ac";
 
+static const char *const FAN_MODES[] = {
+    fan_modes::FAN_AUTO, fan_modes::FAN_LOW, fan_modes::FAN_MED, fan_modes::FAN_HIGH, fan_modes::FAN_TURBO,
+};
+static const uint8_t FAN_MODES_COUNT = sizeof(FAN_MODES) / sizeof(FAN_MODES[0]);
+
+const char *fan_mode_name(uint8_t index) {
+    return index < FAN_MODES_COUNT ? FAN_MODES[index] : fan_modes::FAN_AUTO;
+}
+
+uint8_t fan_mode_index(const char *name) {
+    for (uint8_t i = 0; i < FAN_MODES_COUNT; i++) {
+        if (strcmp(FAN_MODES[i], name) == 0) return i;
+    }
+    return 0;
+}
+
+float temperature_to_float(int16_t temperature) {
+    return temperature == TEMPERATURE_UNKNOWN ? NAN : temperature * 0.1f;
+}
+
+int16_t temperature_from_float(float temperature) {
+    return std::isnan(temperature) ? TEMPERATURE_UNKNOWN : (int16_t) lroundf(temperature * 10);
+}
+
 climate::ClimateTraits SinclairAC::traits() {
     auto traits = climate::ClimateTraits();
 
     traits.add_feature_flags(climate::CLIMATE_SUPPORTS_CURRENT_TEMPERATURE);
+    traits.add_feature_flags(climate::CLIMATE_SUPPORTS_ACTION);
     
     traits.set_visual_min_temperature(MIN_TEMPERATURE);
     traits.set_visual_max_temperature(MAX_TEMPERATURE);
@@ -30,181 +66,401 @@ climate::ClimateTraits SinclairAC::traits() {
 void SinclairAC::setup() {
     this->init_time_ = millis();
     this->last_packet_sent_ = millis();
+    this->rx_stats_.free_heap_min = UINT32_MAX;
+    this->set_interval("diagnostics", DIAGNOSTICS_PUBLISH_INTERVAL_MS, [this]() { this->publish_diagnostics(); });
     ESP_LOGI(TAG, "Sinclair AC component starting...");
 }
 
 void SinclairAC::loop() {
     read_data();
+    handle_frames();
 }
 
 void SinclairAC::read_data() {
-    while (available()) {
-        if (this->serialProcess_.state == STATE_COMPLETE) {
-            break;
+    if (!available()) {
+        /* a frame that lost bytes would otherwise swallow the start of the next one */
+        if (this->parser_.in_frame() && millis() - this->last_byte_received_ > READ_TIMEOUT) {
+            ESP_LOGD(TAG, "Dropping partial frame, no data for %u ms", READ_TIMEOUT);
+            this->parser_.abort();
         }
+        return;
+    }
+    this->last_byte_received_ = millis();
+
+    /* complete frames are queued, so several of them can be taken from the UART in one go */
+    while (available() && !this->frames_.full()) {
         uint8_t c;
         this->read_byte(&c);
+        this->rx_stats_.loop_bytes++;
+        if (this->parser_.feed(c)) {
+            this->last_packet_received_ = millis();
+            this->tx_window_open_ = true;
+            this->wait_response_ = false;
+            this->frames_.push(this->parser_.frame());
+            this->parser_.reset();
+            if (!this->within_budget()) break;
+        }
+    }
+}
+
+bool SinclairAC::rx_idle() {
+    /* member checks first, once the turn is over an idle tick costs the single available() call of a plain poll */
+    if (this->parser_.in_frame() || !this->frames_.empty() || available()) return false;
+    if (this->tx_window_open_ && millis() - this->last_packet_received_ < TX_WINDOW_MS) return false;
+    this->tx_window_open_ = false;
+    return true;
+}
 
-        if (this->serialProcess_.state == STATE_RESTART) {
-            this->serialProcess_.data.clear();
-            this->serialProcess_.state = STATE_WAIT_SYNC;
+bool SinclairAC::can_transmit() {
+    if (this->wait_response_) return false;
+    /* never start writing while the unit is in the middle of a frame */
+    if (this->parser_.in_frame() || available()) return false;
+    return millis() - this->last_packet_received_ < TX_WINDOW_MS;
+}
+
+void SinclairAC::send_frame(const uint8_t *data, size_t length) {
+    this->write_array(data, length);
+    this->last_packet_sent_ = millis();
+    this->wait_response_ = true;
+    this->log_packet(data, length, true);
+}
+
+bool SinclairAC::register_frame_handler(uint8_t type, FrameHandler handler) {
+    if (this->frame_handlers_count_ >= MAX_FRAME_HANDLERS) {
+        ESP_LOGE(TAG, "No room for a handler of frame type 0x%02X", type);
+        return false;
+    }
+    this->frame_handlers_[this->frame_handlers_count_++] = {type, std::move(handler)};
+    this->parser_.accept(type);
+    return true;
+}
+
+void SinclairAC::handle_frames() {
+    FrameView frame;
+    while (this->frames_.front(&frame)) {
+        const uint8_t type = frame.type();
+        this->count_frame(type);
+        if (frame.skipped()) {
+            ESP_LOGV(TAG, "Skipped frame 0x%02X, %u bytes", type, frame[2] + FRAME_HEADER_LEN);
+        } else {
+            this->log_packet(frame.data, frame.size, false);
+            for (uint8_t i = 0; i < this->frame_handlers_count_; i++) {
+                if (this->frame_handlers_[i].type == type) {
+                    this->frame_handlers_[i].handler(frame);
+                    break;
+                }
+            }
         }
-        
-        this->serialProcess_.data.push_back(c);
-        if (this->serialProcess_.data.size() >= DATA_MAX) {
-            this->serialProcess_.data.clear();
-            continue;
+        this->frames_.pop();
+        /* whatever does not fit into this loop is handled in the next one */
+        if (!this->within_budget()) break;
+    }
+}
+
+void SinclairAC::count_frame(uint8_t type) {
+    switch (type) {
+        case 0x31: this->rx_stats_.frames_unit_report++; break;
+        case 0x33: this->rx_stats_.frames_0x33++; break;
+        case 0x44: this->rx_stats_.frames_0x44++; break;
+        default: this->rx_stats_.frames_other++; break;
+    }
+}
+
+static uint32_t get_free_heap() {
+#if defined(USE_ESP8266)
+    return ESP.getFreeHeap();
+#elif defined(USE_ESP32)
+    return heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+#else
+    return 0;
+#endif
+}
+
+uint32_t SinclairAC::loop_start() {
+    this->loop_started_ = micros();
+    return this->loop_started_;
+}
+
+void SinclairAC::loop_end(uint32_t start) {
+    if (this->rx_stats_.loop_bytes > this->rx_stats_.loop_bytes_max) {
+        this->rx_stats_.loop_bytes_max = this->rx_stats_.loop_bytes;
+    }
+    this->rx_stats_.loop_bytes = 0;
+
+    if (this->loop_time_max_sensor_ != nullptr || this->loop_time_total_sensor_ != nullptr) {
+        uint32_t duration = micros() - start;
+        if (duration > this->rx_stats_.loop_time_max) {
+            this->rx_stats_.loop_time_max = duration;
         }
-        switch (this->serialProcess_.state) {
-            case STATE_WAIT_SYNC:
-                if (c != 0x7E && 
-                    this->serialProcess_.data.size() > 2 && 
-                    this->serialProcess_.data[this->serialProcess_.data.size()-2] == 0x7E && 
-                    this->serialProcess_.data[this->serialProcess_.data.size()-3] == 0x7E) {
-                    this->serialProcess_.data.clear();
-                    this->serialProcess_.data.push_back(0x7E);
-                    this->serialProcess_.data.push_back(0x7E);
-                    this->serialProcess_.data.push_back(c);
-                    this->serialProcess_.frame_size = c;
-                    this->serialProcess_.state = STATE_RECIEVE;
-                }
-                break;
-            case STATE_RECIEVE:
-                this->serialProcess_.frame_size--;
-                if (this->serialProcess_.frame_size == 0) {
-                    this->serialProcess_.state = STATE_COMPLETE;
-                }
-                break;
-            default:
-                break;
+        this->rx_stats_.loop_time_total += duration;
+    }
+    uint32_t backlog_bytes = available();
+    if (backlog_bytes > this->rx_stats_.backlog_bytes_max) {
+        this->rx_stats_.backlog_bytes_max = backlog_bytes;
+    }
+    if (this->frames_.size() > this->rx_stats_.backlog_frames_max) {
+        this->rx_stats_.backlog_frames_max = this->frames_.size();
+    }
+    if (this->free_heap_min_sensor_ != nullptr) {
+        uint32_t free_heap = get_free_heap();
+        if (free_heap < this->rx_stats_.free_heap_min) {
+            this->rx_stats_.free_heap_min = free_heap;
         }
     }
 }
 
-void SinclairAC::update_current_temperature(float temperature) {
+void SinclairAC::publish_diagnostics() {
+    const FrameStats_t &parser = this->parser_.stats();
+
+    if (this->rx_frames_unit_report_sensor_ != nullptr)
+        this->rx_frames_unit_report_sensor_->publish_state(this->rx_stats_.frames_unit_report);
+    if (this->rx_frames_0x33_sensor_ != nullptr)
+        this->rx_frames_0x33_sensor_->publish_state(this->rx_stats_.frames_0x33);
+    if (this->rx_frames_0x44_sensor_ != nullptr)
+        this->rx_frames_0x44_sensor_->publish_state(this->rx_stats_.frames_0x44);
+    if (this->rx_frames_other_sensor_ != nullptr)
+        this->rx_frames_other_sensor_->publish_state(this->rx_stats_.frames_other);
+    if (this->checksum_errors_sensor_ != nullptr)
+        this->checksum_errors_sensor_->publish_state(this->rx_stats_.checksum_errors);
+    if (this->overflow_drops_sensor_ != nullptr)
+        this->overflow_drops_sensor_->publish_state(parser.overflows);
+    if (this->resync_events_sensor_ != nullptr)
+        this->resync_events_sensor_->publish_state(parser.resyncs);
+    if (this->frame_timeouts_sensor_ != nullptr)
+        this->frame_timeouts_sensor_->publish_state(parser.timeouts);
+    if (this->loop_bytes_max_sensor_ != nullptr)
+        this->loop_bytes_max_sensor_->publish_state(this->rx_stats_.loop_bytes_max);
+    if (this->loop_time_max_sensor_ != nullptr)
+        this->loop_time_max_sensor_->publish_state(this->rx_stats_.loop_time_max);
+    if (this->loop_time_total_sensor_ != nullptr)
+        this->loop_time_total_sensor_->publish_state(this->rx_stats_.loop_time_total);
+    if (this->first_publish_time_sensor_ != nullptr && this->first_publish_ != 0)
+        this->first_publish_time_sensor_->publish_state(this->first_publish_);
+    if (this->publishes_emitted_sensor_ != nullptr)
+        this->publishes_emitted_sensor_->publish_state(this->publish_emitted_);
+    if (this->publishes_suppressed_sensor_ != nullptr)
+        this->publishes_suppressed_sensor_->publish_state(this->publish_suppressed_);
+    if (this->free_heap_min_sensor_ != nullptr && this->rx_stats_.free_heap_min != UINT32_MAX)
+        this->free_heap_min_sensor_->publish_state(this->rx_stats_.free_heap_min);
+    if (this->rx_backlog_bytes_max_sensor_ != nullptr)
+        this->rx_backlog_bytes_max_sensor_->publish_state(this->rx_stats_.backlog_bytes_max);
+    if (this->rx_backlog_frames_max_sensor_ != nullptr)
+        this->rx_backlog_frames_max_sensor_->publish_state(this->rx_stats_.backlog_frames_max);
+
+    /* maxima are reported per publish interval */
+    this->rx_stats_.loop_bytes_max = 0;
+    this->rx_stats_.loop_time_max = 0;
+    this->rx_stats_.loop_time_total = 0;
+    this->rx_stats_.backlog_bytes_max = 0;
+    this->rx_stats_.backlog_frames_max = 0;
+}
+
+static bool select_differs(select::Select *select, uint8_t index) {
+    auto active = select->active_index();
+    return !active.has_value() || *active != index;
+}
+
+bool SinclairAC::should_publish(uint16_t field, bool changed) {
+    if (changed || (this->published_fields_ & field) == 0) {
+        this->published_fields_ |= field;
+        this->publish_emitted_++;
+        return true;
+    }
+    this->publish_suppressed_++;
+    return false;
+}
+
+void SinclairAC::publish_climate() {
+    /* every caller changed mode, target or room temperature, the action follows them */
+    this->action = this->determine_action();
+    /* small current temperature jitter is not worth a publish on its own, it is sent along with other changes */
+    bool changed = this->mode != this->published_.mode ||
+                   this->action != this->published_.action ||
+                   this->swing_mode != this->published_.swing_mode ||
+                   this->target_temperature_ != this->published_.target_temperature ||
+                   this->get_custom_fan_mode().c_str() != this->published_.custom_fan_mode ||
+                   temperature_differs(this->current_temperature_, this->published_.current_temperature,
+                                       this->current_temperature_hysteresis_);
+    if (!this->should_publish(publish_fields::CLIMATE, changed)) return;
+
+    this->published_.mode = this->mode;
+    this->published_.action = this->action;
+    this->published_.swing_mode = this->swing_mode;
+    this->published_.target_temperature = this->target_temperature_;
+    this->published_.current_temperature = this->current_temperature_;
+    this->published_.custom_fan_mode = this->get_custom_fan_mode().c_str();
+
+    this->target_temperature = temperature_to_float(this->target_temperature_);
+    this->current_temperature = temperature_to_float(this->current_temperature_);
+
+    if (this->first_publish_ == 0) {
+        this->first_publish_ = millis();
+        ESP_LOGI(TAG, "First climate publish %" PRIu32 " ms after boot", this->first_publish_);
+    }
+
+    this->publish_state();
+}
+
+void SinclairAC::update_current_temperature(int16_t temperature) {
     if (temperature > TEMPERATURE_THRESHOLD) return;
-    this->current_temperature = temperature;
+    this->current_temperature_ = temperature;
 }
 
-void SinclairAC::update_target_temperature(float temperature) {
+void SinclairAC::update_target_temperature(int16_t temperature) {
     if (temperature > TEMPERATURE_THRESHOLD) return;
-    this->target_temperature = temperature;
+    this->target_temperature_ = temperature;
 }
 
-void SinclairAC::update_swing_horizontal(const std::string &swing) {
+void SinclairAC::update_swing_horizontal(uint8_t swing) {
     this->horizontal_swing_state_ = swing;
     if (this->horizontal_swing_select_ != nullptr &&
-        this->horizontal_swing_select_->current_option() != this->horizontal_swing_state_) {
-        this->horizontal_swing_select_->publish_state(this->horizontal_swing_state_);
+        this->should_publish(publish_fields::HSWING, select_differs(this->horizontal_swing_select_, this->horizontal_swing_state_))) {
+        this->horizontal_swing_select_->publish_state((size_t) this->horizontal_swing_state_);
     }
 }
 
-void SinclairAC::update_swing_vertical(const std::string &swing) {
+void SinclairAC::update_swing_vertical(uint8_t swing) {
     this->vertical_swing_state_ = swing;
-    if (this->vertical_swing_select_ != nullptr && 
-        this->vertical_swing_select_->current_option() != this->vertical_swing_state_) {
-        this->vertical_swing_select_->publish_state(this->vertical_swing_state_);
+    if (this->vertical_swing_select_ != nullptr &&
+        this->should_publish(publish_fields::VSWING, select_differs(this->vertical_swing_select_, this->vertical_swing_state_))) {
+        this->vertical_swing_select_->publish_state((size_t) this->vertical_swing_state_);
     }
 }
 
-void SinclairAC::update_display(const std::string &display) {
+void SinclairAC::update_display(uint8_t display) {
     this->display_state_ = display;
-    if (this->display_select_ != nullptr && 
-        this->display_select_->current_option() != this->display_state_) {
-        this->display_select_->publish_state(this->display_state_);
+    if (this->display_select_ != nullptr &&
+        this->should_publish(publish_fields::DISPLAY, select_differs(this->display_select_, this->display_state_))) {
+        this->display_select_->publish_state((size_t) this->display_state_);
     }
 }
 
-void SinclairAC::update_display_unit(const std::string &display_unit) {
+void SinclairAC::update_display_unit(uint8_t display_unit) {
     this->display_unit_state_ = display_unit;
-    if (this->display_unit_select_ != nullptr && 
-        this->display_unit_select_->current_option() != this->display_unit_state_) {
-        this->display_unit_select_->publish_state(this->display_unit_state_);
+    if (this->display_unit_select_ != nullptr &&
+        this->should_publish(publish_fields::DISPLAY_UNIT, select_differs(this->display_unit_select_, this->display_unit_state_))) {
+        this->display_unit_select_->publish_state((size_t) this->display_unit_state_);
     }
 }
 
 void SinclairAC::update_plasma(bool plasma) {
     this->plasma_state_ = plasma;
-    if (this->plasma_switch_ != nullptr) this->plasma_switch_->publish_state(this->plasma_state_);
+    if (this->plasma_switch_ != nullptr &&
+        this->should_publish(publish_fields::PLASMA, this->plasma_switch_->state != this->plasma_state_)) {
+        this->plasma_switch_->publish_state(this->plasma_state_);
+    }
 }
 
 void SinclairAC::update_beeper(bool beeper) {
     this->beeper_state_ = beeper;
-    if (this->beeper_switch_ != nullptr) this->beeper_switch_->publish_state(this->beeper_state_);
+    if (this->beeper_switch_ != nullptr &&
+        this->should_publish(publish_fields::BEEPER, this->beeper_switch_->state != this->beeper_state_)) {
+        this->beeper_switch_->publish_state(this->beeper_state_);
+    }
 }
 
 void SinclairAC::update_sleep(bool sleep) {
     this->sleep_state_ = sleep;
-    if (this->sleep_switch_ != nullptr) this->sleep_switch_->publish_state(this->sleep_state_);
+    if (this->sleep_switch_ != nullptr &&
+        this->should_publish(publish_fields::SLEEP, this->sleep_switch_->state != this->sleep_state_)) {
+        this->sleep_switch_->publish_state(this->sleep_state_);
+    }
 }
 
 void SinclairAC::update_xfan(bool xfan) {
     this->xfan_state_ = xfan;
-    if (this->xfan_switch_ != nullptr) this->xfan_switch_->publish_state(this->xfan_state_);
+    if (this->xfan_switch_ != nullptr &&
+        this->should_publish(publish_fields::XFAN, this->xfan_switch_->state != this->xfan_state_)) {
+        this->xfan_switch_->publish_state(this->xfan_state_);
+    }
 }
 
 void SinclairAC::update_save(bool save) {
     this->save_state_ = save;
-    if (this->save_switch_ != nullptr) this->save_switch_->publish_state(this->save_state_);
+    if (this->save_switch_ != nullptr &&
+        this->should_publish(publish_fields::SAVE, this->save_switch_->state != this->save_state_)) {
+        this->save_switch_->publish_state(this->save_state_);
+    }
 }
 
 climate::ClimateAction SinclairAC::determine_action() {
     if (this->mode == climate::CLIMATE_MODE_OFF) return climate::CLIMATE_ACTION_OFF;
     if (this->mode == climate::CLIMATE_MODE_FAN_ONLY) return climate::CLIMATE_ACTION_FAN;
     if (this->mode == climate::CLIMATE_MODE_DRY) return climate::CLIMATE_ACTION_DRYING;
-    if ((this->mode == climate::CLIMATE_MODE_COOL || this->mode == climate::CLIMATE_MODE_HEAT_COOL) &&
-        this->current_temperature + TEMPERATURE_TOLERANCE >= this->target_temperature) return climate::CLIMATE_ACTION_COOLING;
-    if ((this->mode == climate::CLIMATE_MODE_HEAT || this->mode == climate::CLIMATE_MODE_HEAT_COOL) &&
-        this->current_temperature - TEMPERATURE_TOLERANCE <= this->target_temperature) return climate::CLIMATE_ACTION_HEATING;
-    return climate::CLIMATE_ACTION_IDLE;
+    /* without a room temperature the unit may just as well be idle, so that is what is shown */
+    const bool may_cool = this->mode == climate::CLIMATE_MODE_COOL || this->mode == climate::CLIMATE_MODE_HEAT_COOL;
+    const bool may_heat = this->mode == climate::CLIMATE_MODE_HEAT || this->mode == climate::CLIMATE_MODE_HEAT_COOL;
+    switch (room_demand(may_cool, may_heat, this->current_temperature_, this->target_temperature_)) {
+        case RoomDemand::Cooling: return climate::CLIMATE_ACTION_COOLING;
+        case RoomDemand::Heating: return climate::CLIMATE_ACTION_HEATING;
+        default: return climate::CLIMATE_ACTION_IDLE;
+    }
 }
 
 void SinclairAC::set_vertical_swing_select(select::Select *vertical_swing_select) {
     this->vertical_swing_select_ = vertical_swing_select;
     this->vertical_swing_select_->add_on_state_callback([this](size_t index) {
-        const auto &options = this->vertical_swing_select_->traits.get_options();
-        if (index >= options.size()) return;
-        const std::string &value = options[index];
-        if (value == this->vertical_swing_state_) return;
-        this->on_vertical_swing_change(value);
+        if (index >= this->vertical_swing_select_->traits.get_options().size()) return;
+        if (index == this->vertical_swing_state_) return;
+        this->on_vertical_swing_change(index);
     });
 }
 
 void SinclairAC::set_horizontal_swing_select(select::Select *horizontal_swing_select) {
     this->horizontal_swing_select_ = horizontal_swing_select;
     this->horizontal_swing_select_->add_on_state_callback([this](size_t index) {
-        const auto &options = this->horizontal_swing_select_->traits.get_options();
-        if (index >= options.size()) return;
-        const std::string &value = options[index];
-        if (value == this->horizontal_swing_state_) return;
-        this->on_horizontal_swing_change(value);
+        if (index >= this->horizontal_swing_select_->traits.get_options().size()) return;
+        if (index == this->horizontal_swing_state_) return;
+        this->on_horizontal_swing_change(index);
     });
 }
 
 void SinclairAC::set_display_select(select::Select *display_select) {
     this->display_select_ = display_select;
     this->display_select_->add_on_state_callback([this](size_t index) {
-        const auto &options = this->display_select_->traits.get_options();
-        if (index >= options.size()) return;
-        const std::string &value = options[index];
-        if (value == this->display_state_) return;
-        this->on_display_change(value);
+        if (index >= this->display_select_->traits.get_options().size()) return;
+        if (index == this->display_state_) return;
+        this->on_display_change(index);
     });
 }
 
 void SinclairAC::set_display_unit_select(select::Select *display_unit_select) {
     this->display_unit_select_ = display_unit_select;
     this->display_unit_select_->add_on_state_callback([this](size_t index) {
-        const auto &options = this->display_unit_select_->traits.get_options();
-        if (index >= options.size()) return;
-        const std::string &value = options[index];
-        if (value == this->display_unit_state_) return;
-        this->on_display_unit_change(value);
+        if (index >= this->display_unit_select_->traits.get_options().size()) return;
+        if (index == this->display_unit_state_) return;
+        this->on_display_unit_change(index);
     });
 }
 
-void SinclairAC::log_packet(std::vector<uint8_t> data, bool outgoing) {
-    ESP_LOGV(TAG, "%s: %s", outgoing ? "TX" : "RX", format_hex_pretty(data).c_str());
+void SinclairAC::log_packet(const uint8_t *data, size_t length, bool outgoing) {
+    /* with a trace configured frames are only copied, formatting happens in dump_trace() */
+    if (this->trace_.enabled()) {
+        this->trace_.record(millis(), data, length, outgoing);
+        return;
+    }
+    ESP_LOGV(TAG, "%s: %s", outgoing ? "TX" : "RX", format_hex_pretty(data, length).c_str());
+}
+
+void SinclairAC::set_frame_trace_size(uint16_t size) {
+    /* allocated once while the configuration is applied, never on the receive path */
+    this->trace_.init(size != 0 ? new uint8_t[size] : nullptr, size);
+}
+
+void SinclairAC::dump_trace() {
+    if (!this->trace_.enabled()) {
+        ESP_LOGW(TAG, "Frame trace is disabled, set frame_trace_size to enable it");
+        return;
+    }
+    ESP_LOGI(TAG, "Frame trace dump (%" PRIu32 " older frames dropped):", this->trace_.dropped());
+
+    uint16_t cursor = 0;
+    TraceRecord_t record;
+    uint8_t data[UINT8_MAX];
+    while (this->trace_.read(&cursor, &record, data)) {
+        ESP_LOGI(TAG, "TRACE %" PRIu32 " %s %s", record.time, (record.flags & TRACE_FLAG_TX) ? "TX" : "RX",
+                 format_hex(data, record.length).c_str());
+    }
 }
 
 void SinclairAC::set_plasma_switch(switch_::Switch *plasma_switch) {
@@ -251,7 +507,7 @@ void SinclairAC::set_current_temperature_sensor(sensor::Sensor *current_temperat
     this->current_temperature_sensor_ = current_temperature_sensor;
     this->current_temperature_sensor_->add_on_state_callback([this](float state) {
         if (std::isnan(state)) return;
-        this->update_current_temperature(state);
+        this->update_current_temperature(temperature_from_float(state));
     });
 }
 
@@ -7,6 +7,13 @@
 #include "esphome/components/switch/switch.h"
 #include "esphome/components/uart/uart.h"
 #include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+
+#include <functional>
+
+#include "esppac_frame.h"
+#include "esppac_temperature.h"
+#include "esppac_trace.h"
 
 namespace esphome {
 
@@ -14,13 +21,9 @@ namespace sinclair_ac {
 
 static const char *const VERSION = "0.0.1";
 
-static const uint8_t READ_TIMEOUT = 20;  // The maximum time to wait before considering a packet complete
-
 static const uint8_t MIN_TEMPERATURE = 16;   // Minimum temperature as reported by EWPE SMART APP
 static const uint8_t MAX_TEMPERATURE = 30;   // Maximum temperature as supported by EWPE SMART APP
 static const float TEMPERATURE_STEP = 1.0;   // Steps the temperature can be set in
-static const float TEMPERATURE_TOLERANCE = 2;  // The tolerance to allow when checking the climate state
-static const uint8_t TEMPERATURE_THRESHOLD = 100;  // Maximum temperature the AC can report (formally 119.5 for sinclair protocol, but 100 is impossible, soo...)
 
 namespace fan_modes{
     const char* const FAN_AUTO  = "0 - Auto";
@@ -30,63 +33,110 @@ namespace fan_modes{
     const char* const FAN_TURBO = "4 - Turbo";
 }
 
-/* this must be same as HORIZONTAL_SWING_OPTIONS in climate.py */
+/* Select states are kept as option indexes, the option strings only exist in the select traits */
+
+/* this must be same order as HORIZONTAL_SWING_OPTIONS in climate.py */
 namespace horizontal_swing_options{
-    const std::string OFF    = "0 - OFF";
-    const std::string FULL   = "1 - Swing - Full";
-    const std::string CLEFT  = "2 - Constant - Left";
-    const std::string CMIDL  = "3 - Constant - Mid-Left";
-    const std::string CMID   = "4 - Constant - Middle";
-    const std::string CMIDR  = "5 - Constant - Mid-Right";
-    const std::string CRIGHT = "6 - Constant - Right";
+    static const uint8_t OFF    = 0;
+    static const uint8_t FULL   = 1;
+    static const uint8_t CLEFT  = 2;
+    static const uint8_t CMIDL  = 3;
+    static const uint8_t CMID   = 4;
+    static const uint8_t CMIDR  = 5;
+    static const uint8_t CRIGHT = 6;
 }
 
-/* this must be same as VERTICAL_SWING_OPTIONS in climate.py */
+/* this must be same order as VERTICAL_SWING_OPTIONS in climate.py */
 namespace vertical_swing_options{
-    const std::string OFF   = "00 - OFF";
-    const std::string FULL  = "01 - Swing - Full";
-    const std::string DOWN  = "02 - Swing - Down";
-    const std::string MIDD  = "03 - Swing - Mid-Down";
-    const std::string MID   = "04 - Swing - Middle";
-    const std::string MIDU  = "05 - Swing - Mid-Up";
-    const std::string UP    = "06 - Swing - Up";
-    const std::string CDOWN = "07 - Constant - Down";
-    const std::string CMIDD = "08 - Constant - Mid-Down";
-    const std::string CMID  = "09 - Constant - Middle";
-    const std::string CMIDU = "10 - Constant - Mid-Up";
-    const std::string CUP   = "11 - Constant - Up";
+    static const uint8_t OFF   = 0;
+    static const uint8_t FULL  = 1;
+    static const uint8_t DOWN  = 2;
+    static const uint8_t MIDD  = 3;
+    static const uint8_t MID   = 4;
+    static const uint8_t MIDU  = 5;
+    static const uint8_t UP    = 6;
+    static const uint8_t CDOWN = 7;
+    static const uint8_t CMIDD = 8;
+    static const uint8_t CMID  = 9;
+    static const uint8_t CMIDU = 10;
+    static const uint8_t CUP   = 11;
 }
 
-/* this must be same as DISPLAY_OPTIONS in climate.py */
+/* this must be same order as DISPLAY_OPTIONS in climate.py */
 namespace display_options{
-    const std::string OFF  = "0 - OFF";
-    const std::string AUTO = "1 - Auto";
-    const std::string SET  = "2 - Set temperature";
-    const std::string ACT  = "3 - Actual temperature";
-    const std::string OUT  = "4 - Outside temperature";
+    static const uint8_t OFF  = 0;
+    static const uint8_t AUTO = 1;
+    static const uint8_t SET  = 2;
+    static const uint8_t ACT  = 3;
+    static const uint8_t OUT  = 4;
 }
 
-/* this must be same as DISPLAY_UNIT_OPTIONS in climate.py */
+/* this must be same order as DISPLAY_UNIT_OPTIONS in climate.py */
 namespace display_unit_options{
-    const std::string DEGC = "C";
-    const std::string DEGF = "F";
+    static const uint8_t DEGC = 0;
+    static const uint8_t DEGF = 1;
 }
 
-typedef enum {
-        STATE_WAIT_SYNC,
-        STATE_RECIEVE,
-        STATE_COMPLETE,
-        STATE_RESTART
-} SerialProcessState_t;
+/* Fan mode string for a fan speed index (fan_modes order) and back, used at the Home Assistant boundary only */
+const char *fan_mode_name(uint8_t index);
+uint8_t fan_mode_index(const char *name);
+
+/* 0.1 degrees C to the float ESPHome uses and back, at the Home Assistant and sensor boundary only */
+float temperature_to_float(int16_t temperature);
+int16_t temperature_from_float(float temperature);
+
+static const uint32_t DEFAULT_LOOP_BUDGET_US = 2000;  // Time per loop() that may be spent draining and handling frames
+static const uint32_t DIAGNOSTICS_PUBLISH_INTERVAL_MS = 30000;  // How often the diagnostic counters are published
 
-static const uint8_t DATA_MAX = 200;
+static const uint8_t MAX_FRAME_HANDLERS = 4;  // Frame types a protocol implementation can subscribe to
+
+/* Called for every received frame of the type it was registered for */
+typedef std::function<void(const FrameView &frame)> FrameHandler;
 
 typedef struct {
-        std::vector<uint8_t> data;
-        uint8_t data_cnt;
-        uint8_t frame_size;
-        SerialProcessState_t state;
-} SerialProcess_t;
+        uint8_t type;
+        FrameHandler handler;
+} FrameHandlerSlot_t;
+
+/* Receive path counters, always counted but only published when the matching sensor is configured */
+typedef struct {
+        uint32_t frames_unit_report;  /* 0x31 frames */
+        uint32_t frames_0x33;
+        uint32_t frames_0x44;
+        uint32_t frames_other;
+        uint32_t checksum_errors;
+        uint32_t loop_bytes;          /* bytes read during the current loop() */
+        uint32_t loop_bytes_max;      /* most bytes read in one loop() since the last publish */
+        uint32_t loop_time_max;       /* longest loop() in us since the last publish */
+        uint32_t loop_time_total;     /* us spent in loop() since the last publish */
+        uint32_t free_heap_min;       /* lowest free heap seen since boot */
+        uint32_t backlog_bytes_max;   /* most bytes left in the UART after a loop() since the last publish */
+        uint32_t backlog_frames_max;  /* most frames left queued after a loop() since the last publish */
+} RxStats_t;
+
+/* Entities published by the component, bit set once an entity has been published for the first time */
+namespace publish_fields {
+    static const uint16_t CLIMATE       = 1 << 0;
+    static const uint16_t HSWING        = 1 << 1;
+    static const uint16_t VSWING        = 1 << 2;
+    static const uint16_t DISPLAY       = 1 << 3;
+    static const uint16_t DISPLAY_UNIT  = 1 << 4;
+    static const uint16_t PLASMA        = 1 << 5;
+    static const uint16_t BEEPER        = 1 << 6;
+    static const uint16_t SLEEP         = 1 << 7;
+    static const uint16_t XFAN          = 1 << 8;
+    static const uint16_t SAVE          = 1 << 9;
+}
+
+/* Climate state as last published to Home Assistant */
+typedef struct {
+        climate::ClimateMode mode;
+        climate::ClimateAction action;
+        climate::ClimateSwingMode swing_mode;
+        int16_t target_temperature;   /* 0.1 degrees C */
+        int16_t current_temperature;  /* 0.1 degrees C */
+        const char *custom_fan_mode;  /* points into the traits, so comparing pointers is enough */
+} ClimateShadow_t;
 
 class SinclairAC : public Component, public uart::UARTDevice, public climate::Climate {
     public:
@@ -103,6 +153,39 @@ class SinclairAC : public Component, public uart::UARTDevice, public climate::Cl
         void set_save_switch(switch_::Switch *plasma_switch);
 
         void set_current_temperature_sensor(sensor::Sensor *current_temperature_sensor);
+        void set_current_temperature_hysteresis(float hysteresis) { this->current_temperature_hysteresis_ = temperature_from_float(hysteresis); }
+        void set_current_temperature_smoothing(uint8_t smoothing) { this->current_temperature_filter_.set_shift(smoothing); }
+
+        void set_command_latency_p50_sensor(sensor::Sensor *sensor) { this->command_latency_p50_sensor_ = sensor; }
+        void set_command_latency_p95_sensor(sensor::Sensor *sensor) { this->command_latency_p95_sensor_ = sensor; }
+        void set_command_latency_max_sensor(sensor::Sensor *sensor) { this->command_latency_max_sensor_ = sensor; }
+        void set_command_retries_sensor(sensor::Sensor *sensor) { this->command_retries_sensor_ = sensor; }
+
+        void set_rx_frames_unit_report_sensor(sensor::Sensor *sensor) { this->rx_frames_unit_report_sensor_ = sensor; }
+        void set_rx_frames_0x33_sensor(sensor::Sensor *sensor) { this->rx_frames_0x33_sensor_ = sensor; }
+        void set_rx_frames_0x44_sensor(sensor::Sensor *sensor) { this->rx_frames_0x44_sensor_ = sensor; }
+        void set_rx_frames_other_sensor(sensor::Sensor *sensor) { this->rx_frames_other_sensor_ = sensor; }
+        void set_checksum_errors_sensor(sensor::Sensor *sensor) { this->checksum_errors_sensor_ = sensor; }
+        void set_overflow_drops_sensor(sensor::Sensor *sensor) { this->overflow_drops_sensor_ = sensor; }
+        void set_resync_events_sensor(sensor::Sensor *sensor) { this->resync_events_sensor_ = sensor; }
+        void set_frame_timeouts_sensor(sensor::Sensor *sensor) { this->frame_timeouts_sensor_ = sensor; }
+        void set_loop_bytes_max_sensor(sensor::Sensor *sensor) { this->loop_bytes_max_sensor_ = sensor; }
+        void set_loop_time_max_sensor(sensor::Sensor *sensor) { this->loop_time_max_sensor_ = sensor; }
+        void set_loop_time_total_sensor(sensor::Sensor *sensor) { this->loop_time_total_sensor_ = sensor; }
+        void set_first_publish_time_sensor(sensor::Sensor *sensor) { this->first_publish_time_sensor_ = sensor; }
+        void set_publishes_emitted_sensor(sensor::Sensor *sensor) { this->publishes_emitted_sensor_ = sensor; }
+        void set_publishes_suppressed_sensor(sensor::Sensor *sensor) { this->publishes_suppressed_sensor_ = sensor; }
+        void set_link_ready_time_sensor(sensor::Sensor *sensor) { this->link_ready_time_sensor_ = sensor; }
+        void set_first_command_time_sensor(sensor::Sensor *sensor) { this->first_command_time_sensor_ = sensor; }
+        void set_free_heap_min_sensor(sensor::Sensor *sensor) { this->free_heap_min_sensor_ = sensor; }
+        void set_rx_backlog_bytes_max_sensor(sensor::Sensor *sensor) { this->rx_backlog_bytes_max_sensor_ = sensor; }
+        void set_rx_backlog_frames_max_sensor(sensor::Sensor *sensor) { this->rx_backlog_frames_max_sensor_ = sensor; }
+
+        void set_loop_budget(uint32_t budget_us) { this->loop_budget_us_ = budget_us; }
+        void set_frame_trace_size(uint16_t size);
+
+        /* Logs every frame kept in the trace, oldest first, one "TRACE <ms> <RX|TX> <hex>" line each */
+        void dump_trace();
 
         void setup() override;
         void loop() override;
@@ -122,42 +205,106 @@ class SinclairAC : public Component, public uart::UARTDevice, public climate::Cl
 
         sensor::Sensor *current_temperature_sensor_ = nullptr; /* If user wants to replace reported temperature by an external sensor readout */
 
-        std::string vertical_swing_state_;
-        std::string horizontal_swing_state_;
-
-        std::string display_state_;
-        std::string display_unit_state_;
-
-        bool plasma_state_;
-        bool beeper_state_;
-        bool sleep_state_;
-        bool xfan_state_;
-        bool save_state_;
-
-        SerialProcess_t serialProcess_;
-
-        float Temrec0 [16];
-        float Temrec1 [16];
+        sensor::Sensor *command_latency_p50_sensor_ = nullptr; /* Diagnostic: median SET to confirmation time */
+        sensor::Sensor *command_latency_p95_sensor_ = nullptr; /* Diagnostic: 95th percentile SET to confirmation time */
+        sensor::Sensor *command_latency_max_sensor_ = nullptr; /* Diagnostic: worst SET to confirmation time */
+        sensor::Sensor *command_retries_sensor_     = nullptr; /* Diagnostic: number of repeated SET frames */
+
+        sensor::Sensor *rx_frames_unit_report_sensor_ = nullptr; /* Diagnostic: received 0x31 frames */
+        sensor::Sensor *rx_frames_0x33_sensor_        = nullptr; /* Diagnostic: received 0x33 frames */
+        sensor::Sensor *rx_frames_0x44_sensor_        = nullptr; /* Diagnostic: received 0x44 frames */
+        sensor::Sensor *rx_frames_other_sensor_       = nullptr; /* Diagnostic: received frames of any other type */
+        sensor::Sensor *checksum_errors_sensor_       = nullptr; /* Diagnostic: frames with a wrong checksum */
+        sensor::Sensor *overflow_drops_sensor_        = nullptr; /* Diagnostic: headers dropped for an impossible length */
+        sensor::Sensor *resync_events_sensor_         = nullptr; /* Diagnostic: frames found after skipping garbage */
+        sensor::Sensor *frame_timeouts_sensor_        = nullptr; /* Diagnostic: partial frames dropped after a gap */
+        sensor::Sensor *loop_bytes_max_sensor_        = nullptr; /* Diagnostic: most bytes read in one loop() */
+        sensor::Sensor *loop_time_max_sensor_         = nullptr; /* Diagnostic: longest loop() duration */
+        sensor::Sensor *loop_time_total_sensor_       = nullptr; /* Diagnostic: time spent in loop() per publish interval */
+        sensor::Sensor *first_publish_time_sensor_    = nullptr; /* Diagnostic: boot to first climate publish */
+        sensor::Sensor *publishes_emitted_sensor_     = nullptr; /* Diagnostic: entity states published */
+        sensor::Sensor *publishes_suppressed_sensor_  = nullptr; /* Diagnostic: entity publishes skipped as unchanged */
+        sensor::Sensor *link_ready_time_sensor_       = nullptr; /* Diagnostic: boot to handshake done */
+        sensor::Sensor *first_command_time_sensor_    = nullptr; /* Diagnostic: boot to first confirmed SET */
+        sensor::Sensor *free_heap_min_sensor_         = nullptr; /* Diagnostic: free heap low-water mark */
+        sensor::Sensor *rx_backlog_bytes_max_sensor_  = nullptr; /* Diagnostic: bytes carried over to the next loop() */
+        sensor::Sensor *rx_backlog_frames_max_sensor_ = nullptr; /* Diagnostic: frames carried over to the next loop() */
+
+        uint8_t vertical_swing_state_ = 0;   /* vertical_swing_options index */
+        uint8_t horizontal_swing_state_ = 0; /* horizontal_swing_options index */
+
+        uint8_t display_state_ = 0;          /* display_options index */
+        uint8_t display_unit_state_ = 0;     /* display_unit_options index */
+        uint8_t fan_state_ = 0;              /* fan_modes index */
+
+        int16_t target_temperature_ = MIN_TEMPERATURE * 10;       /* 0.1 degrees C, published as target_temperature */
+        int16_t current_temperature_ = TEMPERATURE_UNKNOWN;      /* 0.1 degrees C, published as current_temperature */
+        TemperatureFilter current_temperature_filter_;           /* Running average of the reported temperature */
+
+        bool plasma_state_ = false;
+        bool beeper_state_ = false;
+        bool sleep_state_ = false;
+        bool xfan_state_ = false;
+        bool save_state_ = false;
+
+        FrameParser parser_;
+        FrameQueue frames_;                          /* Complete frames waiting to be handled */
+        RxStats_t rx_stats_{};
+        FrameTrace trace_;                           /* Recent RX/TX frames, empty unless frame_trace_size is set */
+        uint32_t loop_budget_us_ = DEFAULT_LOOP_BUDGET_US;
+        uint32_t loop_started_ = 0;                  /* micros() at the start of the current loop() */
+        uint32_t last_byte_received_ = 0;            /* millis() when the UART last had data */
+
+        FrameHandlerSlot_t frame_handlers_[MAX_FRAME_HANDLERS];
+        uint8_t frame_handlers_count_ = 0;
+
+        ClimateShadow_t published_{};                /* Climate state as last published */
+        uint16_t published_fields_ = 0;              /* publish_fields:: bits published at least once */
+        int16_t current_temperature_hysteresis_ = 0; /* Minimum current temperature change worth publishing, 0.1 degrees C */
+        uint32_t publish_emitted_ = 0;               /* Number of publishes sent to Home Assistant */
+        uint32_t publish_suppressed_ = 0;            /* Number of publishes skipped as nothing changed */
+        uint32_t first_publish_ = 0;                 /* millis() of the first climate publish, 0 before it */
 
         uint32_t init_time_;   // Stores the current time
         // uint32_t last_read_;   // Stores the time at which the last read was done
         uint32_t last_packet_sent_;  // Stores the time at which the last packet was sent
         uint32_t last_03packet_sent_;  // Stores the time at which the last packet was sent
-        uint32_t last_packet_received_;  // Stores the time at which the last packet was received
-        bool wait_response_;
+        uint32_t last_packet_received_ = 0;  // Stores the time at which the last packet was received
+        bool wait_response_ = false;     // A frame was sent in the current turn, the unit has to talk first
+        bool tx_window_open_ = false;    // TX_WINDOW_MS after the last received frame has not been seen to pass yet
 
         climate::ClimateTraits traits() override;
 
         void read_data();
 
-        void update_current_temperature(float temperature);
-        void update_target_temperature(float temperature);
+        /* Nothing on the line, nothing queued and no turn to send in: loop() has nothing to do */
+        bool rx_idle();
+
+        /* The line is half duplex: at most one frame is sent in the gap after each received frame */
+        bool can_transmit();
+        void send_frame(const uint8_t *data, size_t length);
+
+        /* Frames of types without a handler are skipped by the parser instead of being buffered */
+        bool register_frame_handler(uint8_t type, FrameHandler handler);
+        void handle_frames();
+
+        void count_frame(uint8_t type);
+        uint32_t loop_start();
+        bool within_budget() const { return micros() - this->loop_started_ < this->loop_budget_us_; }
+        void loop_end(uint32_t start);
+        void publish_diagnostics();
+
+        bool should_publish(uint16_t field, bool changed);
+        void publish_climate();
+
+        void update_current_temperature(int16_t temperature);
+        void update_target_temperature(int16_t temperature);
 
-        void update_swing_horizontal(const std::string &swing);
-        void update_swing_vertical(const std::string &swing);
+        void update_swing_horizontal(uint8_t swing);
+        void update_swing_vertical(uint8_t swing);
 
-        void update_display(const std::string &display);
-        void update_display_unit(const std::string &display_unit);
+        void update_display(uint8_t display);
+        void update_display_unit(uint8_t display_unit);
 
         void update_plasma(bool plasma);
         void update_beeper(bool beeper);
@@ -165,11 +312,11 @@ class SinclairAC : public Component, public uart::UARTDevice, public climate::Cl
         void update_xfan(bool xfan);
         void update_save(bool save);
 
-        virtual void on_horizontal_swing_change(const std::string &swing) = 0;
-        virtual void on_vertical_swing_change(const std::string &swing) = 0;
+        virtual void on_horizontal_swing_change(uint8_t swing) = 0;
+        virtual void on_vertical_swing_change(uint8_t swing) = 0;
 
-        virtual void on_display_change(const std::string &display) = 0;
-        virtual void on_display_unit_change(const std::string &display_unit) = 0;
+        virtual void on_display_change(uint8_t display) = 0;
+        virtual void on_display_unit_change(uint8_t display_unit) = 0;
 
         virtual void on_plasma_change(bool plasma) = 0;
         virtual void on_beeper_change(bool beeper) = 0;
@@ -179,7 +326,7 @@ class SinclairAC : public Component, public uart::UARTDevice, public climate::Cl
 
         climate::ClimateAction determine_action();
 
-        void log_packet(std::vector<uint8_t> data, bool outgoing = false);
+        void log_packet(const uint8_t *data, size_t length, bool outgoing = false);
 };
 
 }  // namespace sinclair_ac
@@ -1,6 +1,7 @@
 #include "esppac_cnt.h"
 #include "esphome/core/log.h"
-#include <cstring>
+#include <cinttypes>
+#include <cmath>
 
 namespace esphome {
 namespace sinclair_ac {
@@ -8,181 +9,623 @@ namespace CNT {
 
 static const char *const TAG = "sinclair_ac_cnt";
 
-void SinclairACCNT::send_packet() {
-    uint8_t packet[47];
-    memset(packet, 0, sizeof(packet));
-
-    packet[0] = 0x7E;
-    packet[1] = 0x7E;
-    packet[2] = 45; // Length
-    packet[3] = protocol::CMD_OUT_PARAMS_SET; // 0x01
-
-    // Set Power
-    if (this->mode != climate::CLIMATE_MODE_OFF) {
-        packet[4 + protocol::REPORT_PWR_BYTE] |= protocol::REPORT_PWR_MASK;
-    }
-
-    // Set Mode
-    uint8_t mode_byte = protocol::REPORT_MODE_AUTO;
-    switch (this->mode) {
-        case climate::CLIMATE_MODE_COOL: mode_byte = protocol::REPORT_MODE_COOL; break;
-        case climate::CLIMATE_MODE_DRY: mode_byte = protocol::REPORT_MODE_DRY; break;
-        case climate::CLIMATE_MODE_HEAT: mode_byte = protocol::REPORT_MODE_HEAT; break;
-        case climate::CLIMATE_MODE_FAN_ONLY: mode_byte = protocol::REPORT_MODE_FAN; break;
-        case climate::CLIMATE_MODE_AUTO: default: mode_byte = protocol::REPORT_MODE_AUTO; break;
-    }
-    packet[4 + protocol::REPORT_MODE_BYTE] |= (mode_byte << protocol::REPORT_MODE_POS);
-
-    // Set Temperature
-    int temp = (int)this->target_temperature;
-    packet[4 + protocol::REPORT_TEMP_SET_BYTE] |= ((temp + protocol::REPORT_TEMP_SET_OFF) << protocol::REPORT_TEMP_SET_POS);
-
-    // Set Fan
-    std::string current_fan = this->get_custom_fan_mode().str();
-    uint8_t fan_byte = 0;
-    if (current_fan == "1 - Low") fan_byte = 1;
-    else if (current_fan == "2 - Medium") fan_byte = 2;
-    else if (current_fan == "3 - High") fan_byte = 3;
-    
-    if (current_fan == "0 - Auto" || current_fan.empty()) {
-        // Auto fan logic if needed, usually 0
-    } else if (current_fan == "4 - Turbo") {
-        packet[4 + protocol::REPORT_FAN_TURBO_BYTE] |= protocol::REPORT_FAN_TURBO_MASK;
-        fan_byte = 3; // Turbo often implies high fan speed + turbo bit
-    }
-    packet[4 + protocol::REPORT_FAN_SPD1_BYTE] |= (fan_byte & protocol::REPORT_FAN_SPD1_MASK);
-
-    // Set Swing
+static const uint16_t CLIMATE_FIELDS =
+    update_fields::MODE | update_fields::TARGET_TEMP | update_fields::FAN | update_fields::SWING;
+
+static void set_unit_mode(UnitState *state, climate::ClimateMode mode) {
+    state->power = mode != climate::CLIMATE_MODE_OFF;
+    switch (mode) {
+        case climate::CLIMATE_MODE_COOL: state->mode = protocol::REPORT_MODE_COOL; break;
+        case climate::CLIMATE_MODE_DRY: state->mode = protocol::REPORT_MODE_DRY; break;
+        case climate::CLIMATE_MODE_HEAT: state->mode = protocol::REPORT_MODE_HEAT; break;
+        case climate::CLIMATE_MODE_FAN_ONLY: state->mode = protocol::REPORT_MODE_FAN; break;
+        case climate::CLIMATE_MODE_AUTO: default: state->mode = protocol::REPORT_MODE_AUTO; break;
+    }
+}
+
+UnitState SinclairACCNT::build_state() {
+    UnitState state{};
+
+    set_unit_mode(&state, this->mode);
+    state.display_fahrenheit = this->display_unit_state_ == display_unit_options::DEGF;
+    if (this->follow_me_active()) {
+        set_unit_set_point(&state, this->follow_me_controller_.output(this->target_temperature_, this->current_temperature_));
+    } else {
+        set_unit_set_point(&state, this->target_temperature_);
+    }
+
+    state.fan = this->fan_state_;
+    state.beeper = this->beeper_state_;
+
     if (this->swing_mode == climate::CLIMATE_SWING_VERTICAL || this->swing_mode == climate::CLIMATE_SWING_BOTH) {
-        packet[4 + protocol::REPORT_VSWING_BYTE] |= (protocol::REPORT_VSWING_FULL << protocol::REPORT_VSWING_POS);
+        state.vswing = protocol::REPORT_VSWING_FULL;
     }
     if (this->swing_mode == climate::CLIMATE_SWING_HORIZONTAL || this->swing_mode == climate::CLIMATE_SWING_BOTH) {
-        packet[4 + protocol::REPORT_HSWING_BYTE] |= (protocol::REPORT_HSWING_FULL << protocol::REPORT_HSWING_POS);
+        state.hswing = protocol::REPORT_HSWING_FULL;
     }
+    return state;
+}
+
+void SinclairACCNT::check_link() {
+    this->link_.check(millis(), this->last_packet_received_);
+    this->handle_link_events();
+}
+
+void SinclairACCNT::transmit() {
+    /* nothing is sent to a unit that is not talking to us */
+    if (this->link_.state() == ACState::Initializing || !this->can_transmit()) return;
+
+    uint8_t packet[LINK_FRAME_MAX];
+    uint8_t size = this->link_.transmit(millis(), packet);
+    if (size != 0) this->send_frame(packet, size);
+    this->handle_link_events();
+}
 
-    // Calculate Checksum
-    uint8_t checksum = 0;
-    for (int i = 2; i < 46; i++) {
-        checksum += packet[i];
+void SinclairACCNT::handle_link_events() {
+    const uint16_t events = this->link_.take_events();
+    if (events == 0) return;
+    const uint32_t now = millis();
+
+    if (events & link_events::LINK_LOST)
+        ESP_LOGW(TAG, "No data from the AC for %lu ms, holding commands until the handshake is done again",
+                 protocol::TIME_TIMEOUT_INACTIVE_MS);
+    if (events & link_events::HANDSHAKE_STARTED)
+        ESP_LOGI(TAG, "AC is talking, sending the handshake");
+    if (events & link_events::LINK_READY) {
+        ESP_LOGI(TAG, "Link ready %" PRIu32 " ms after boot, handshake took %" PRIu32 " ms", now,
+                 now - this->link_.link_up());
+        if (this->link_ready_time_sensor_ != nullptr) this->link_ready_time_sensor_->publish_state(this->link_.link_ready_time());
     }
-    packet[46] = checksum;
 
-    this->write_array(packet, 47);
-    this->log_packet(std::vector<uint8_t>(packet, packet + 47), true);
+    const PendingCommand_t &command = this->link_.command();
+    if (events & link_events::SET_SENT)
+        ESP_LOGD(TAG, "Sending SET: %u request(s) merged, fields 0x%04X (%" PRIu32 " requests in %" PRIu32 " frames since boot)",
+                 this->link_.merged_requests(), command.fields, this->link_.requests_total(), this->link_.set_frames_total());
+    if (events & link_events::SET_REPEATED)
+        ESP_LOGD(TAG, "SET not confirmed, retry %u", command.retries);
+    if (events & link_events::SET_FAILED)
+        ESP_LOGW(TAG, "SET not confirmed by the AC after %u retries, giving up", command.retries);
+    if (events & link_events::SET_CONFIRMED)
+        ESP_LOGD(TAG, "SET confirmed after %" PRIu32 " ms, %u retries", this->link_.last_latency(), command.retries);
+    if (events & link_events::FIRST_COMMAND)
+        ESP_LOGI(TAG, "First SET confirmed %" PRIu32 " ms after boot", this->link_.first_command_time());
+
+    if (events & (link_events::SET_REPEATED | link_events::SET_CONFIRMED)) this->publish_command_stats();
 }
 
-bool SinclairACCNT::processUnitReport() {
-    if (this->serialProcess_.data.size() < 47) return false;
+void SinclairACCNT::publish_command_stats() {
+    const LatencyHistogram &latency = this->link_.latency();
+    if (this->command_latency_p50_sensor_ != nullptr)
+        this->command_latency_p50_sensor_->publish_state(latency.percentile(50));
+    if (this->command_latency_p95_sensor_ != nullptr)
+        this->command_latency_p95_sensor_->publish_state(latency.percentile(95));
+    if (this->command_latency_max_sensor_ != nullptr)
+        this->command_latency_max_sensor_->publish_state(latency.max());
+    if (this->command_retries_sensor_ != nullptr)
+        this->command_retries_sensor_->publish_state(this->link_.retries_total());
+    if (this->first_command_time_sensor_ != nullptr && this->link_.first_command_time() != 0)
+        this->first_command_time_sensor_->publish_state(this->link_.first_command_time());
+}
 
-    // Verify Checksum
-    uint8_t checksum = 0;
-    for (size_t i = 2; i < this->serialProcess_.data.size() - 1; i++) {
-        checksum += this->serialProcess_.data[i];
-    }
-    if (checksum != this->serialProcess_.data.back()) {
+bool SinclairACCNT::processUnitReport(const FrameView &frame) {
+    UnitState state;
+    DecodeResult result = this->link_.on_report(frame, millis(), &state);
+    if (result == DecodeResult::BadChecksum) {
+        this->rx_stats_.checksum_errors++;
         ESP_LOGW(TAG, "Checksum mismatch");
-        return false;
     }
+    if (result != DecodeResult::Ok) return false;
 
-    // Log received packet
-    this->log_packet(this->serialProcess_.data, false);
+    if (!this->have_report_) {
+        ESP_LOGI(TAG, "First unit report %" PRIu32 " ms after boot", millis());
+        if (this->have_saved_) {
+            uint16_t changed = differing_fields(state, this->saved_.unit);
+            if (changed != 0) ESP_LOGI(TAG, "Fields 0x%04X changed since the state was saved", changed);
+        }
+    }
+    this->handle_link_events();
+
+    /* requested values the report does not show yet stay as published until confirmed or given up */
+    uint16_t masked = this->link_.pending_fields() & differing_fields(state, this->link_.requested());
+    if (this->have_report_) {
+        /* a pending value that moved somewhere we did not ask for was changed with the remote, the unit wins */
+        uint16_t external = masked & differing_fields(state, this->last_report_);
+        if (external != 0) {
+            ESP_LOGD(TAG, "Fields 0x%04X changed on the unit, dropping the pending request", external);
+            this->link_.drop_pending(external, state);
+            masked &= ~external;
+        }
+    }
+    this->last_report_ = state;
+    this->have_report_ = true;
 
-    // Parse Power
-    bool power = (this->serialProcess_.data[4 + protocol::REPORT_PWR_BYTE] & protocol::REPORT_PWR_MASK);
-    this->mode = power ? climate::CLIMATE_MODE_COOL : climate::CLIMATE_MODE_OFF; // Simplified, needs full mode mapping
+    this->apply_state(state, masked);
+    /* an external sensor replaces the reported temperature */
+    if (this->current_temperature_sensor_ == nullptr)
+        this->update_current_temperature(this->current_temperature_filter_.add(state.current_temperature));
+
+    this->publish_climate();
+    this->save_state(state);
+    return true;
+}
+
+/* takes over every field of state not in masked, the room temperature is left to the caller */
+void SinclairACCNT::apply_state(const UnitState &state, uint16_t masked) {
+    if (!(masked & update_fields::MODE))
+        this->mode = this->determine_mode(state);
+    if (!(masked & update_fields::FAN)) {
+        this->fan_state_ = state.fan;
+        this->set_custom_fan_mode_(StringRef(fan_mode_name(this->fan_state_)));
+    }
+    if (!(masked & update_fields::SWING))
+        this->swing_mode = this->determine_swing_mode(state);
+    /* while follow me steers the unit it shows the controller output, the target is what was asked for;
+       otherwise the set point is the unit's and changes made with the remote are taken over */
+    if (!(masked & update_fields::TARGET_TEMP) && !this->follow_me_active())
+        this->update_target_temperature(unit_set_point(state));
+
+    if (!(masked & update_fields::VSWING))
+        this->update_swing_vertical(this->determine_vertical_swing(state));
+    if (!(masked & update_fields::HSWING))
+        this->update_swing_horizontal(this->determine_horizontal_swing(state));
+
+    if (!(masked & update_fields::DISPLAY))
+        this->update_display(this->determine_display(state));
+    if (!(masked & update_fields::DISPLAY_UNIT))
+        this->update_display_unit(this->determine_display_unit(state));
+
+    /* beeper is a setting of this module (silent commands), it is not taken over from the AC */
+    if (!(masked & update_fields::PLASMA))
+        this->update_plasma(state.plasma);
+    if (!(masked & update_fields::SLEEP))
+        this->update_sleep(state.sleep);
+    if (!(masked & update_fields::XFAN))
+        this->update_xfan(state.xfan);
+    if (!(masked & update_fields::SAVE))
+        this->update_save(state.save);
+}
 
-    // Parse Mode if powered on
-    if (power) {
-        uint8_t mode_byte = (this->serialProcess_.data[4 + protocol::REPORT_MODE_BYTE] & protocol::REPORT_MODE_MASK) >> protocol::REPORT_MODE_POS;
-        switch (mode_byte) {
-            case protocol::REPORT_MODE_COOL: this->mode = climate::CLIMATE_MODE_COOL; break;
-            case protocol::REPORT_MODE_HEAT: this->mode = climate::CLIMATE_MODE_HEAT; break;
-            case protocol::REPORT_MODE_DRY: this->mode = climate::CLIMATE_MODE_DRY; break;
-            case protocol::REPORT_MODE_FAN: this->mode = climate::CLIMATE_MODE_FAN_ONLY; break;
-            case protocol::REPORT_MODE_AUTO: this->mode = climate::CLIMATE_MODE_AUTO; break;
+void SinclairACCNT::restore_state() {
+    /* ESP32 keeps RTC and flash preferences in the same NVS namespace, keyed by the hash alone, so the two
+       copies need keys of their own; the name keeps both clear of the climate's own restore state */
+    const uint32_t hash = fnv1_hash("saved_state") ^ this->get_object_id_hash() ^ SAVED_STATE_VERSION;
+    this->rtc_pref_ = global_preferences->make_preference<SavedState_t>(hash, false);
+    this->flash_pref_ = global_preferences->make_preference<SavedState_t>(hash ^ 0x1, true);
+
+    /* RTC memory is newer when it survived, flash only holds what was synced before power went */
+    const char *source = "RTC memory";
+    if (!this->rtc_pref_.load(&this->saved_)) {
+        source = "flash";
+        if (!this->flash_pref_.load(&this->saved_)) {
+            ESP_LOGI(TAG, "No saved state, waiting for the first unit report");
+            return;
         }
     }
+    this->have_saved_ = true;
+
+    /* shown until the first report, which takes over every field again */
+    this->apply_state(this->saved_.unit, 0);
+    this->target_temperature_ = this->saved_.target;
+    this->update_beeper(this->saved_.beeper);
+    this->link_.set_beeper(this->saved_.beeper);
+    this->publish_climate();
+    ESP_LOGI(TAG, "Restored state saved in %s", source);
+}
 
-    // Parse Temperature
-    uint8_t temp_raw = (this->serialProcess_.data[4 + protocol::REPORT_TEMP_SET_BYTE] & protocol::REPORT_TEMP_SET_MASK) >> protocol::REPORT_TEMP_SET_POS;
-    this->target_temperature = temp_raw - protocol::REPORT_TEMP_SET_OFF;
+void SinclairACCNT::save_state(const UnitState &report) {
+    if (this->have_saved_ && differing_fields(report, this->saved_.unit) == 0 &&
+        this->saved_.target == this->target_temperature_ && this->saved_.beeper == this->beeper_state_) return;
+
+    this->saved_.unit = report;
+    this->saved_.unit.current_temperature = 0;
+    this->saved_.target = this->target_temperature_;
+    this->saved_.beeper = this->beeper_state_;
+    this->have_saved_ = true;
+    /* the flash copy is written at the next preferences sync, not right away */
+    this->rtc_pref_.save(&this->saved_);
+    this->flash_pref_.save(&this->saved_);
+}
 
-    // Parse Current Temperature
-    uint8_t curr_temp_raw = this->serialProcess_.data[4 + protocol::REPORT_TEMP_ACT_BYTE];
-    this->current_temperature = (curr_temp_raw - protocol::REPORT_TEMP_ACT_OFF) / protocol::REPORT_TEMP_ACT_DIV;
+/* Names accepted by set_schedule_entry() */
+typedef struct {
+    const char *name;
+    uint8_t value;
+} ScheduleName_t;
+
+static const ScheduleName_t SCHEDULE_MODES[] = {
+    {"off", climate::CLIMATE_MODE_OFF},   {"cool", climate::CLIMATE_MODE_COOL},
+    {"heat", climate::CLIMATE_MODE_HEAT}, {"dry", climate::CLIMATE_MODE_DRY},
+    {"fan_only", climate::CLIMATE_MODE_FAN_ONLY}, {"auto", climate::CLIMATE_MODE_AUTO},
+};
+/* fan_modes order */
+static const ScheduleName_t SCHEDULE_FANS[] = {
+    {"auto", 0}, {"low", 1}, {"medium", 2}, {"high", 3}, {"turbo", 4},
+};
+static const ScheduleName_t SCHEDULE_SWINGS[] = {
+    {"off", climate::CLIMATE_SWING_OFF}, {"vertical", climate::CLIMATE_SWING_VERTICAL},
+    {"horizontal", climate::CLIMATE_SWING_HORIZONTAL}, {"both", climate::CLIMATE_SWING_BOTH},
+};
+
+template<size_t N> static bool schedule_value(const ScheduleName_t (&names)[N], const std::string &name, uint8_t *value) {
+    for (const ScheduleName_t &entry : names) {
+        if (name == entry.name) {
+            *value = entry.value;
+            return true;
+        }
+    }
+    return false;
+}
 
-    this->publish_state();
+template<size_t N> static const char *schedule_name(const ScheduleName_t (&names)[N], uint8_t value) {
+    if (value == SCHEDULE_KEEP) return "keep";
+    for (const ScheduleName_t &entry : names) {
+        if (entry.value == value) return entry.name;
+    }
+    return "?";
+}
+
+bool SinclairACCNT::set_schedule_entry(int index, const std::string &days, int hour, int minute, const std::string &mode,
+                                       float target, const std::string &fan, const std::string &swing) {
+    ScheduleEntry entry{};
+    entry.days = parse_schedule_days(days.c_str());
+    entry.minute = hour * 60 + minute;
+    entry.target = std::isnan(target) || target == 0 ? SCHEDULE_TARGET_KEEP : temperature_from_float(target);
+    entry.fan = SCHEDULE_KEEP;
+    entry.swing = SCHEDULE_KEEP;
+
+    bool valid = hour >= 0 && hour < 24 && minute >= 0 && minute < 60 && schedule_value(SCHEDULE_MODES, mode, &entry.mode);
+    if (entry.target != SCHEDULE_TARGET_KEEP && (entry.target < MIN_TEMPERATURE * 10 || entry.target > MAX_TEMPERATURE * 10))
+        valid = false;
+    if (!fan.empty() && !schedule_value(SCHEDULE_FANS, fan, &entry.fan)) valid = false;
+    if (!swing.empty() && !schedule_value(SCHEDULE_SWINGS, swing, &entry.swing)) valid = false;
+    if (!valid || !this->schedule_.set(index, entry)) {
+        ESP_LOGW(TAG, "Schedule entry %d rejected: %s %02d:%02d %s", index, days.c_str(), hour, minute, mode.c_str());
+        return false;
+    }
+
+    if (!this->schedule_pref_.save(&this->schedule_) || !global_preferences->sync())
+        ESP_LOGW(TAG, "Schedule entry %d set but not saved, is a time_id configured for the schedule?", index);
+    ESP_LOGI(TAG, "Schedule entry %d set", index);
     return true;
 }
 
+bool SinclairACCNT::clear_schedule_entry(int index) {
+    if (!this->schedule_.clear(index)) {
+        ESP_LOGW(TAG, "Schedule entry %d rejected, valid entries are 0 to %u", index, SCHEDULE_MAX_ENTRIES - 1);
+        return false;
+    }
+    if (!this->schedule_pref_.save(&this->schedule_) || !global_preferences->sync())
+        ESP_LOGW(TAG, "Schedule entry %d cleared but not saved", index);
+    ESP_LOGI(TAG, "Schedule entry %d cleared", index);
+    return true;
+}
+
+void SinclairACCNT::dump_schedule() {
+    ESP_LOGI(TAG, "Schedule: %u of %u entries used", this->schedule_.count(), SCHEDULE_MAX_ENTRIES);
+    for (uint8_t i = 0; i < SCHEDULE_MAX_ENTRIES; i++) {
+        const ScheduleEntry &entry = this->schedule_.entry(i);
+        if (entry.days == 0) continue;
+        char days[8];
+        format_schedule_days(entry.days, days);
+        ESP_LOGI(TAG, "  %2u: %s %02u:%02u %-8s target %5.1f fan %-6s swing %s", i, days, entry.minute / 60,
+                 entry.minute % 60, schedule_name(SCHEDULE_MODES, entry.mode),
+                 entry.target == SCHEDULE_TARGET_KEEP ? NAN : temperature_to_float(entry.target),
+                 schedule_name(SCHEDULE_FANS, entry.fan), schedule_name(SCHEDULE_SWINGS, entry.swing));
+    }
+}
+
+void SinclairACCNT::restore_schedule() {
+#ifdef USE_TIME
+    if (this->schedule_clock_ == nullptr) return;
+    this->schedule_pref_ = global_preferences->make_preference<Schedule>(
+        fnv1_hash("schedule") ^ this->get_object_id_hash() ^ SCHEDULE_VERSION, true);
+    if (this->schedule_pref_.load(&this->schedule_))
+        ESP_LOGI(TAG, "Restored %u schedule entries", this->schedule_.count());
+    this->set_interval("schedule", SCHEDULE_CHECK_INTERVAL_MS, [this]() { this->check_schedule(); });
+#endif
+}
+
+void SinclairACCNT::check_schedule() {
+#ifdef USE_TIME
+    if (this->schedule_clock_ == nullptr) return;
+    ESPTime time = this->schedule_clock_->now();
+    if (!time.is_valid()) return;
+    uint16_t minute = (time.day_of_week - 1) * MINUTES_PER_DAY + time.hour * 60 + time.minute;
+    if (minute == this->schedule_minute_) return;
+
+    /* nothing is caught up at boot, the restored state already is what the unit runs */
+    const ScheduleEntry *entry = nullptr;
+    if (this->schedule_minute_ != SCHEDULE_MINUTE_UNKNOWN) {
+        uint16_t elapsed = (minute + MINUTES_PER_WEEK - this->schedule_minute_) % MINUTES_PER_WEEK;
+        if (elapsed <= SCHEDULE_CATCH_UP_MINUTES) entry = this->schedule_.due(this->schedule_minute_, minute);
+        else ESP_LOGD(TAG, "Clock moved by %u minutes, schedule entries passed over are skipped", elapsed);
+    }
+    this->schedule_minute_ = minute;
+    if (entry == nullptr) return;
+
+    ESP_LOGI(TAG, "Schedule entry %u due", (unsigned) (entry - &this->schedule_.entry(0)));
+    this->apply_schedule_entry(*entry);
+#endif
+}
+
+/* goes through the same path as a climate call from Home Assistant, group members included */
+void SinclairACCNT::apply_schedule_entry(const ScheduleEntry &entry) {
+    uint16_t fields = update_fields::MODE;
+    this->mode = (climate::ClimateMode) entry.mode;
+    if (entry.target != SCHEDULE_TARGET_KEEP) {
+        this->target_temperature_ = entry.target;
+        fields |= update_fields::TARGET_TEMP;
+    }
+    if (entry.fan != SCHEDULE_KEEP) {
+        this->fan_state_ = entry.fan;
+        this->set_custom_fan_mode_(StringRef(fan_mode_name(this->fan_state_)));
+        fields |= update_fields::FAN;
+    }
+    if (entry.swing != SCHEDULE_KEEP) {
+        this->swing_mode = (climate::ClimateSwingMode) entry.swing;
+        fields |= update_fields::SWING;
+    }
+    this->change_climate(fields);
+}
+
+climate::ClimateMode SinclairACCNT::determine_mode(const UnitState &state) {
+    if (!state.power) return climate::CLIMATE_MODE_OFF;
+    switch (state.mode) {
+        case protocol::REPORT_MODE_COOL: return climate::CLIMATE_MODE_COOL;
+        case protocol::REPORT_MODE_HEAT: return climate::CLIMATE_MODE_HEAT;
+        case protocol::REPORT_MODE_DRY: return climate::CLIMATE_MODE_DRY;
+        case protocol::REPORT_MODE_FAN: return climate::CLIMATE_MODE_FAN_ONLY;
+        case protocol::REPORT_MODE_AUTO: return climate::CLIMATE_MODE_AUTO;
+        default: return climate::CLIMATE_MODE_COOL;
+    }
+}
+
+climate::ClimateSwingMode SinclairACCNT::determine_swing_mode(const UnitState &state) {
+    bool vertical = state.vswing == protocol::REPORT_VSWING_FULL;
+    bool horizontal = state.hswing == protocol::REPORT_HSWING_FULL;
+    if (vertical && horizontal) return climate::CLIMATE_SWING_BOTH;
+    if (vertical) return climate::CLIMATE_SWING_VERTICAL;
+    if (horizontal) return climate::CLIMATE_SWING_HORIZONTAL;
+    return climate::CLIMATE_SWING_OFF;
+}
+
+/* vertical_swing_options index for every REPORT_VSWING_* value */
+static constexpr uint8_t VSWING_OPTIONS[] = {
+    vertical_swing_options::OFF,   vertical_swing_options::FULL,  vertical_swing_options::CUP,
+    vertical_swing_options::CMIDU, vertical_swing_options::CMID,  vertical_swing_options::CMIDD,
+    vertical_swing_options::CDOWN, vertical_swing_options::DOWN,  vertical_swing_options::MIDD,
+    vertical_swing_options::MID,   vertical_swing_options::MIDU,  vertical_swing_options::UP,
+};
+
+uint8_t SinclairACCNT::determine_vertical_swing(const UnitState &state) {
+    if (state.vswing >= sizeof(VSWING_OPTIONS)) return vertical_swing_options::OFF;
+    return VSWING_OPTIONS[state.vswing];
+}
+
+uint8_t SinclairACCNT::determine_horizontal_swing(const UnitState &state) {
+    /* horizontal options are in the same order as REPORT_HSWING_* values */
+    if (state.hswing > protocol::REPORT_HSWING_CRIGHT) return horizontal_swing_options::OFF;
+    return state.hswing;
+}
+
+uint8_t SinclairACCNT::determine_display(const UnitState &state) {
+    if (!state.display_on) return display_options::OFF;
+    switch (state.display_mode) {
+        case protocol::REPORT_DISP_MODE_SET: return display_options::SET;
+        case protocol::REPORT_DISP_MODE_ACT: return display_options::ACT;
+        case protocol::REPORT_DISP_MODE_OUT: return display_options::OUT;
+        case protocol::REPORT_DISP_MODE_AUTO: default: return display_options::AUTO;
+    }
+}
+
+uint8_t SinclairACCNT::determine_display_unit(const UnitState &state) {
+    return state.display_fahrenheit ? display_unit_options::DEGF : display_unit_options::DEGC;
+}
+
 void SinclairACCNT::setup() {
     SinclairAC::setup();
+    uint8_t mac[6];
+    get_mac_address_raw(mac);
+    this->link_.set_mac(mac);
+    /* frame types without a handler never reach the queue */
+    this->register_frame_handler(protocol::CMD_IN_UNIT_REPORT,
+                                 [this](const FrameView &frame) { this->processUnitReport(frame); });
+    this->restore_state();
+    this->restore_schedule();
+    /* runs off the scheduler like the schedule, loop() does nothing between frames */
+    this->set_interval("link", LINK_CHECK_INTERVAL_MS, [this]() { this->check_link(); });
+    if (this->follow_me_) {
+        this->follow_me_controller_.set_limits(MIN_TEMPERATURE * 10, MAX_TEMPERATURE * 10);
+        this->set_interval("follow_me", FOLLOW_ME_INTERVAL_MS, [this]() { this->update_follow_me(); });
+    }
+}
+
+void SinclairACCNT::set_follow_me(float kp, float ki) {
+    this->follow_me_ = true;
+    this->follow_me_controller_.set_gains(lroundf(kp * 256), lroundf(ki * 256));
+}
+
+bool SinclairACCNT::follow_me_active() const {
+    if (!this->follow_me_) return false;
+    UnitState state{};
+    set_unit_mode(&state, this->mode);
+    return follow_me_applies(state, this->current_temperature_);
+}
+
+void SinclairACCNT::update_follow_me() {
+    if (!this->follow_me_active()) {
+        this->follow_me_controller_.reset();
+        return;
+    }
+    this->follow_me_controller_.integrate(this->target_temperature_, this->current_temperature_, FOLLOW_ME_INTERVAL_MS);
+    if (this->link_.state() != ACState::Ready || !this->have_report_) return;
+
+    /* only whole set point steps reach the unit, anything smaller stays in the controller */
+    UnitState state = this->build_state();
+    if (!(differing_fields(state, this->last_report_) & update_fields::TARGET_TEMP)) return;
+    if ((this->link_.pending_fields() & update_fields::TARGET_TEMP) &&
+        !(differing_fields(state, this->link_.requested()) & update_fields::TARGET_TEMP)) return;
+    ESP_LOGD(TAG, "Follow me: room %d, target %d (0.1 C), sending set point %u", this->current_temperature_,
+             this->target_temperature_, state.target_temperature);
+    this->link_.request(update_fields::TARGET_TEMP, state);
 }
 
 void SinclairACCNT::loop() {
+    if (this->rx_idle()) return;
+    const uint32_t loop_start = this->loop_start();
     SinclairAC::loop();
-    if (this->serialProcess_.state == STATE_COMPLETE) {
-        if (this->serialProcess_.data.size() > 0 && this->serialProcess_.data[3] == protocol::CMD_IN_UNIT_REPORT) {
-            this->processUnitReport();
-        }
-        this->serialProcess_.state = STATE_WAIT_SYNC;
-        this->serialProcess_.data.clear();
-    }
+    this->transmit();
+    this->loop_end(loop_start);
 }
 
 void SinclairACCNT::control(const climate::ClimateCall &call) {
-    if (call.get_mode().has_value())
+    uint16_t fields = 0;
+    if (call.get_mode().has_value()) {
         this->mode = *call.get_mode();
-    if (call.get_target_temperature().has_value())
-        this->target_temperature = *call.get_target_temperature();
-    if (call.get_fan_mode().has_value())
+        fields |= update_fields::MODE;
+    }
+    if (call.get_target_temperature().has_value()) {
+        this->target_temperature_ = temperature_from_float(*call.get_target_temperature());
+        fields |= update_fields::TARGET_TEMP;
+    }
+    if (call.get_fan_mode().has_value()) {
         this->fan_mode = *call.get_fan_mode();
-    if (call.get_swing_mode().has_value())
+        fields |= update_fields::FAN;
+    }
+    if (call.get_swing_mode().has_value()) {
         this->swing_mode = *call.get_swing_mode();
+        fields |= update_fields::SWING;
+    }
     // Fix: Handle StringRef return type and missing setter
     if (!call.get_custom_fan_mode().empty()) {
         this->set_custom_fan_mode_(call.get_custom_fan_mode());
+        this->fan_state_ = fan_mode_index(call.get_custom_fan_mode().c_str());
+        fields |= update_fields::FAN;
     }
     if (call.get_preset().has_value())
         this->preset = *call.get_preset();
-        
-    this->send_packet();
+
+    this->change_climate(fields);
 }
 
-void SinclairACCNT::on_horizontal_swing_change(const std::string &swing) {
-    this->send_packet();
+void SinclairACCNT::change_climate(uint16_t fields) {
+    this->request_climate_update(fields);
+    /* members pick the request up in this same loop pass, each sends it in its own turn on its own UART */
+    for (SinclairACCNT *member = this->group_; member != nullptr; member = member->group_next_) {
+        member->apply_group_update(*this, fields);
+    }
 }
 
-void SinclairACCNT::on_vertical_swing_change(const std::string &swing) {
-    this->send_packet();
+void SinclairACCNT::add_group_member(SinclairACCNT *member) {
+    /* climate.py rejects such configurations, a second link would cut the first group's list short */
+    if (member == this || member->group_leader_ != nullptr) {
+        ESP_LOGW(TAG, "%s is already in a group, not adding it to the group of %s", member->get_name().c_str(),
+                 this->get_name().c_str());
+        return;
+    }
+    if (member->group_ != nullptr || this->group_leader_ != nullptr) {
+        ESP_LOGW(TAG, "Groups cannot be nested, not adding %s to the group of %s", member->get_name().c_str(),
+                 this->get_name().c_str());
+        return;
+    }
+    member->group_leader_ = this;
+    member->group_next_ = this->group_;
+    this->group_ = member;
 }
 
-void SinclairACCNT::on_display_change(const std::string &display) {
-    this->send_packet();
+void SinclairACCNT::apply_group_update(const SinclairACCNT &leader, uint16_t fields) {
+    if (fields & update_fields::MODE) this->mode = leader.mode;
+    if (fields & update_fields::TARGET_TEMP) this->target_temperature_ = leader.target_temperature_;
+    if (fields & update_fields::FAN) {
+        this->fan_state_ = leader.fan_state_;
+        this->set_custom_fan_mode_(StringRef(fan_mode_name(this->fan_state_)));
+    }
+    if (fields & update_fields::SWING) this->swing_mode = leader.swing_mode;
+    this->request_climate_update(fields);
+}
+
+void SinclairACCNT::request_climate_update(uint16_t fields) {
+    /* what was learnt for heating says nothing about cooling */
+    if (fields & update_fields::MODE) this->follow_me_controller_.reset();
+    this->link_.request(fields, this->build_state());
+    /* shown right away, reports contradicting it are masked until the unit confirms */
+    this->publish_climate();
+}
+
+static uint8_t vertical_swing_value(uint8_t option) {
+    for (uint8_t value = 0; value < sizeof(VSWING_OPTIONS); value++) {
+        if (VSWING_OPTIONS[value] == option) return value;
+    }
+    return protocol::REPORT_VSWING_OFF;
+}
+
+void SinclairACCNT::on_horizontal_swing_change(uint8_t swing) {
+    this->horizontal_swing_state_ = swing;
+    UnitState values = this->link_.requested();
+    values.hswing = swing;
+    this->link_.request(update_fields::HSWING, values);
+}
+
+void SinclairACCNT::on_vertical_swing_change(uint8_t swing) {
+    this->vertical_swing_state_ = swing;
+    UnitState values = this->link_.requested();
+    values.vswing = vertical_swing_value(swing);
+    this->link_.request(update_fields::VSWING, values);
+}
+
+void SinclairACCNT::on_display_change(uint8_t display) {
+    this->display_state_ = display;
+    UnitState values = this->link_.requested();
+    values.display_on = display != display_options::OFF;
+    switch (display) {
+        case display_options::SET: values.display_mode = protocol::REPORT_DISP_MODE_SET; break;
+        case display_options::ACT: values.display_mode = protocol::REPORT_DISP_MODE_ACT; break;
+        case display_options::OUT: values.display_mode = protocol::REPORT_DISP_MODE_OUT; break;
+        default: values.display_mode = protocol::REPORT_DISP_MODE_AUTO; break;
+    }
+    this->link_.request(update_fields::DISPLAY, values);
 }
 
-void SinclairACCNT::on_display_unit_change(const std::string &display_unit) {
-    this->send_packet();
+void SinclairACCNT::on_display_unit_change(uint8_t display_unit) {
+    this->display_unit_state_ = display_unit;
+    UnitState values = this->link_.requested();
+    values.display_fahrenheit = display_unit == display_unit_options::DEGF;
+    this->link_.request(update_fields::DISPLAY_UNIT, values);
 }
 
 void SinclairACCNT::on_plasma_change(bool plasma) {
-    this->send_packet();
+    this->plasma_state_ = plasma;
+    UnitState values = this->link_.requested();
+    values.plasma = plasma;
+    this->link_.request(update_fields::PLASMA, values);
 }
 
 void SinclairACCNT::on_beeper_change(bool beeper) {
-    this->send_packet();
+    this->beeper_state_ = beeper;
+    UnitState values = this->link_.requested();
+    values.beeper = beeper;
+    this->link_.request(update_fields::BEEPER, values);
 }
 
 void SinclairACCNT::on_sleep_change(bool sleep) {
-    this->send_packet();
+    this->sleep_state_ = sleep;
+    UnitState values = this->link_.requested();
+    values.sleep = sleep;
+    this->link_.request(update_fields::SLEEP, values);
 }
 
 void SinclairACCNT::on_xfan_change(bool xfan) {
-    this->send_packet();
+    this->xfan_state_ = xfan;
+    UnitState values = this->link_.requested();
+    values.xfan = xfan;
+    this->link_.request(update_fields::XFAN, values);
 }
 
 void SinclairACCNT::on_save_change(bool save) {
-    this->send_packet();
+    this->save_state_ = save;
+    UnitState values = this->link_.requested();
+    values.save = save;
+    this->link_.request(update_fields::SAVE, values);
 }
 
 } // namespace CNT
@@ -1,163 +1,58 @@
 // based on: https://github.com/DomiStyle/esphome-panasonic-ac
+#pragma once
+
 #include "esphome/components/climate/climate.h"
 #include "esphome/components/climate/climate_mode.h"
+#include "esphome/core/preferences.h"
 #include "esppac.h"
+#include "esppac_cnt_link.h"
+#include "esppac_cnt_protocol.h"
+#include "esppac_follow_me.h"
+#include "esppac_schedule.h"
+#include "esppac_stats.h"
+
+#ifdef USE_TIME
+#include "esphome/components/time/real_time_clock.h"
+#endif
 
 namespace esphome {
 namespace sinclair_ac {
 namespace CNT {
 
-enum class ACState {
-    Initializing, /* no data for quite a long time */
-    Ready,        /* AC talking to us */
-};
+/* How often follow me moves the set point sent to the unit */
+static const uint32_t FOLLOW_ME_INTERVAL_MS = 30000;
 
-enum class ACUpdate {
-    NoUpdate,    /* no parameters changed - normally process data, static flag set */
-    UpdateStart, /* start update with 0xAF and cleared static flag */
-    UpdateClear, /* update without 0xAF and cleared static flag */
-};
+/* How often the link timeout is checked, a silent unit is noticed at most this late */
+static const uint32_t LINK_CHECK_INTERVAL_MS = 100;
+
+/* How often the clock is looked at for schedule entries that became due */
+static const uint32_t SCHEDULE_CHECK_INTERVAL_MS = 1000;
+/* Clock steps up to this many minutes forward still apply the entries passed over (DST, a late SNTP
+   sync), longer ones and steps backwards only move on, so a whole week is never replayed */
+static const uint16_t SCHEDULE_CATCH_UP_MINUTES = 90;
+static const uint16_t SCHEDULE_MINUTE_UNKNOWN = 0xFFFF;
+/* Bump when ScheduleEntry changes */
+static const uint32_t SCHEDULE_VERSION = 1;
 
-namespace protocol {
-    /* SYNC */
-    static const uint8_t SYNC                = 0x7E;
-    /* packet types */
-    static const uint8_t CMD_IN_UNIT_REPORT  = 0x31;
-    static const uint8_t CMD_OUT_PARAMS_SET  = 0x01;
-    static const uint8_t CMD_OUT_SYNC_TIME   = 0x03;
-    static const uint8_t CMD_OUT_MAC_REPORT  = 0x04; /* 7e 7e 0d 04 04 00 00 00 AA BB CC DD EE FF 00 -> AA BB CC DD EE FF = MAC address */
-    static const uint8_t CMD_OUT_UNKNOWN_1   = 0x02; /* 7e 7e 10 02 00 00 00 00 00 00 01 00 28 1e 19 23 23 00 b8 */
-    static const uint8_t CMD_IN_UNKNOWN_1    = 0x44; /* 7e 7e 1a 44 01 00 01 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 01 */
-    static const uint8_t CMD_IN_UNKNOWN_2    = 0x33; /* 7e 7e 2f 33 00 00 40 00 09 20 19 0a 00 10 00 14 17 5b 08 08 00 00 00 00 00 00 00 00 01 00 00 0d 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 */
-
-    /* byte indexes are AFTER we remove first 4 bytes from the packet (sync, length, type) as well as a checksum */
-    /* unit report packet data fields, for binary values there is no need to define bit offset/position */
-    static const uint8_t REPORT_PWR_BYTE       = 4;
-    static const uint8_t REPORT_PWR_MASK       = 0b10000000;
-
-    static const uint8_t REPORT_MODE_BYTE      = 4;
-    static const uint8_t REPORT_MODE_MASK      = 0b01110000;
-    static const uint8_t REPORT_MODE_POS       = 4;
-    static const uint8_t REPORT_MODE_AUTO          = 0;
-    static const uint8_t REPORT_MODE_COOL          = 1;
-    static const uint8_t REPORT_MODE_DRY           = 2;
-    static const uint8_t REPORT_MODE_FAN           = 3;
-    static const uint8_t REPORT_MODE_HEAT          = 4;
-
-    static const uint8_t REPORT_FAN_SPD1_BYTE  = 18;
-    static const uint8_t REPORT_FAN_SPD1_MASK  = 0b00001111;
-    static const uint8_t REPORT_FAN_SPD1_POS   = 0;
-    static const uint8_t REPORT_FAN_SPD2_BYTE  = 4;
-    static const uint8_t REPORT_FAN_SPD2_MASK  = 0b00000011;
-    static const uint8_t REPORT_FAN_SPD2_POS   = 0;
-    static const uint8_t REPORT_FAN_QUIET_BYTE = 16;
-    static const uint8_t REPORT_FAN_QUIET_MASK = 0b00001000;
-    static const uint8_t REPORT_FAN_TURBO_BYTE = 6;
-    static const uint8_t REPORT_FAN_TURBO_MASK = 0b00000001;
-
-    static const uint8_t REPORT_FAN_MODE_MASK = 0b00000011;
-
-    static const uint8_t REPORT_TEMP_SET_BYTE  = 5;
-    static const uint8_t REPORT_TEMP_SET_MASK  = 0b11110000;
-    static const uint8_t REPORT_TEMP_SET_POS   = 4;
-    static const uint8_t REPORT_TEMP_SET_OFF   = 16; /* temperature offset from value in packet */
-
-    static const uint8_t REPORT_TEMP_ACT_BYTE  = 42;
-    static const uint8_t REPORT_TEMP_ACT_MASK  = 0b11111111;
-    static const uint8_t REPORT_TEMP_ACT_POS   = 0;
-    static const uint8_t REPORT_TEMP_ACT_OFF   = 16;  /* temperature offset from value in packet */
-    static const float   REPORT_TEMP_ACT_DIV   = 2.0; /* temperature divider from value in packet */
-
-    static const uint8_t REPORT_HSWING_BYTE    = 8;
-    static const uint8_t REPORT_HSWING_MASK    = 0b00000111;
-    static const uint8_t REPORT_HSWING_POS     = 0;
-    static const uint8_t REPORT_HSWING_OFF         = 0;
-    static const uint8_t REPORT_HSWING_FULL        = 1;
-    static const uint8_t REPORT_HSWING_CLEFT       = 2;
-    static const uint8_t REPORT_HSWING_CMIDL       = 3;
-    static const uint8_t REPORT_HSWING_CMID        = 4;
-    static const uint8_t REPORT_HSWING_CMIDR       = 5;
-    static const uint8_t REPORT_HSWING_CRIGHT      = 6;
-
-    static const uint8_t REPORT_VSWING_BYTE    = 8;
-    static const uint8_t REPORT_VSWING_MASK    = 0b11110000;
-    static const uint8_t REPORT_VSWING_POS     = 4;
-    static const uint8_t REPORT_VSWING_OFF         = 0;
-    static const uint8_t REPORT_VSWING_FULL        = 1;
-    static const uint8_t REPORT_VSWING_CUP         = 2;
-    static const uint8_t REPORT_VSWING_CMIDU       = 3;
-    static const uint8_t REPORT_VSWING_CMID        = 4;
-    static const uint8_t REPORT_VSWING_CMIDD       = 5;
-    static const uint8_t REPORT_VSWING_CDOWN       = 6;
-    static const uint8_t REPORT_VSWING_DOWN        = 7;
-    static const uint8_t REPORT_VSWING_MIDD        = 8;
-    static const uint8_t REPORT_VSWING_MID         = 9;
-    static const uint8_t REPORT_VSWING_MIDU        = 10;
-    static const uint8_t REPORT_VSWING_UP          = 11;
-
-    static const uint8_t REPORT_DISP_ON_BYTE   = 6;
-    static const uint8_t REPORT_DISP_ON_MASK   = 0b00000010;
-    static const uint8_t REPORT_DISP_MODE_BYTE = 9;
-    static const uint8_t REPORT_DISP_MODE_MASK = 0b00110000;
-    static const uint8_t REPORT_DISP_MODE_POS  = 4;
-    static const uint8_t REPORT_DISP_MODE_AUTO     = 0;
-    static const uint8_t REPORT_DISP_MODE_SET      = 1;
-    static const uint8_t REPORT_DISP_MODE_ACT      = 2;
-    static const uint8_t REPORT_DISP_MODE_OUT      = 3;
-
-    static const uint8_t REPORT_DISP_F_BYTE    = 7;
-    static const uint8_t TEMREC_MASK           = 0b01000000;
-    static const uint8_t REPORT_DISP_F_MASK    = 0b10000000;
-
-    static const uint8_t REPORT_PLASMA1_BYTE   = 6;
-    static const uint8_t REPORT_PLASMA1_MASK   = 0b00000100;
-    static const uint8_t REPORT_PLASMA2_BYTE   = 0;
-    static const uint8_t REPORT_PLASMA2_MASK   = 0b00000100;
-
-    static const uint8_t REPORT_SLEEP_BYTE     = 4;
-    static const uint8_t REPORT_SLEEP_MASK     = 0b00001000;
-
-    static const uint8_t REPORT_XFAN_BYTE      = 6;
-    static const uint8_t REPORT_XFAN_MASK      = 0b00001000;
-
-    static const uint8_t REPORT_SAVE_BYTE      = 11;
-    static const uint8_t REPORT_SAVE_MASK      = 0b01000000;
-
-    static const uint8_t REPORT_BEEPER_BYTE    = 40;
-    static const uint8_t REPORT_BEEPER_MASK    = 0b00000001;
-
-    /* SET packet shares all the byte definition with REPORT */
-    static const uint8_t SET_PACKET_LEN        = 45;
-    
-    static const uint8_t SET_CONST_02_BYTE     = 39;
-    static const uint8_t SET_CONST_02_VAL      = 0x02;
-
-    static const uint8_t SET_AF_BYTE           = 3;
-    static const uint8_t SET_AF_VAL            = 0xAF;
-
-    static const uint8_t SET_NOCHANGE_BYTE     = 11;
-    static const uint8_t SET_NOCHANGE_MASK     = 0b00001000;
-
-    static const uint8_t SET_CONST_BIT_BYTE    = 7;
-    static const uint8_t SET_CONST_BIT_MASK    = 0b00000010;
-
-    /* time constraints */
-    static const unsigned long TIME_REFRESH_PERIOD_MS   =  300;
-    static const unsigned long TIME_TIMEOUT_INACTIVE_MS = 1000;
-}
-
-/* Define packets from AC that would be processed by software */
-const std::vector<uint8_t> allowedPackets = {protocol::CMD_IN_UNIT_REPORT};
+/* State kept across restarts: RTC memory survives a soft reset or OTA, flash survives power loss */
+typedef struct {
+    UnitState unit;   /* last unit report, the room temperature is not kept */
+    int16_t target;   /* target_temperature_, only differs from the report with follow me */
+    bool beeper;
+} SavedState_t;
+
+/* Bump when SavedState_t changes, so an old image is not loaded into the new layout */
+static const uint32_t SAVED_STATE_VERSION = 1;
 
 class SinclairACCNT : public SinclairAC {
     public:
         void control(const climate::ClimateCall &call) override;
 
-        void on_horizontal_swing_change(const std::string &swing) override;
-        void on_vertical_swing_change(const std::string &swing) override;
+        void on_horizontal_swing_change(uint8_t swing) override;
+        void on_vertical_swing_change(uint8_t swing) override;
 
-        void on_display_change(const std::string &display) override;
-        void on_display_unit_change(const std::string &display_unit) override;
+        void on_display_change(uint8_t display) override;
+        void on_display_unit_change(uint8_t display_unit) override;
 
         void on_plasma_change(bool plasma) override;
         void on_beeper_change(bool beeper) override;
@@ -168,40 +63,94 @@ class SinclairACCNT : public SinclairAC {
         void setup() override;
         void loop() override;
 
+        /* Commands received by this unit are repeated on every member. A unit can be in one group only and a
+           member cannot lead a group of its own, members breaking that are refused with a warning. */
+        void add_group_member(SinclairACCNT *member);
+
+        /* Regulate on current_temperature_sensor by moving the set point sent to the unit, gains as in FollowMeController */
+        void set_follow_me(float kp, float ki);
+
+#ifdef USE_TIME
+        /* Enables the schedule, entries are evaluated against this clock's local time */
+        void set_schedule_clock(time::RealTimeClock *clock) { this->schedule_clock_ = clock; }
+#endif
+        /* Schedule edits, meant for API actions. days as parse_schedule_days(), mode "off", "cool", "heat",
+           "dry", "fan_only" or "auto", target in degrees C or 0 (or NaN) to keep it, fan "auto", "low", "medium",
+           "high", "turbo" and swing "off", "vertical", "horizontal", "both", empty to keep them.
+           The table is written to flash right away, false if the entry was rejected. */
+        bool set_schedule_entry(int index, const std::string &days, int hour, int minute, const std::string &mode,
+                                float target, const std::string &fan, const std::string &swing);
+        bool clear_schedule_entry(int index);
+        /* Logs every entry of the schedule */
+        void dump_schedule();
+
     protected:
-        ACState state_ = ACState::Initializing; /* Stores if the AC is responsive or not */
-        ACUpdate update_ = ACUpdate::NoUpdate;  /* Stores if we need tu send update to AC or no */
+        UnitLink link_;                         /* Handshake, pending requests and SET confirmation, on millis() */
+
+        SinclairACCNT *group_ = nullptr;        /* First member of the group this unit leads */
+        SinclairACCNT *group_next_ = nullptr;   /* Next member in the leader's group */
+        SinclairACCNT *group_leader_ = nullptr; /* Leader of the group this unit is a member of */
+
+        UnitState last_report_{};               /* Last unit report, used to tell remote control changes apart */
+        bool have_report_ = false;
+
+        ESPPreferenceObject rtc_pref_;
+        ESPPreferenceObject flash_pref_;
+        SavedState_t saved_{};                  /* State as last saved or restored */
+        bool have_saved_ = false;
+
+        bool follow_me_ = false;                /* Set point sent is the controller output instead of the target */
+        FollowMeController follow_me_controller_;
+
+        Schedule schedule_{};                   /* Timed changes applied without Home Assistant */
+        ESPPreferenceObject schedule_pref_;
+        uint16_t schedule_minute_ = SCHEDULE_MINUTE_UNKNOWN; /* Minute of the week evaluated last */
+#ifdef USE_TIME
+        time::RealTimeClock *schedule_clock_ = nullptr;
+#endif
 
         climate::ClimateMode mode_internal_;
         bool power_internal_;
 
-        std::string display_mode_internal_;
-        bool display_power_internal_;
+        bool processUnitReport(const FrameView &frame);
+        void apply_state(const UnitState &state, uint16_t masked);
+
+        void restore_state();
+        void save_state(const UnitState &report);
+
+        void restore_schedule();
+        void check_schedule();
+        void apply_schedule_entry(const ScheduleEntry &entry);
 
-        bool processUnitReport();
+        UnitState build_state();
 
-        void send_packet();
+        void check_link();
+        void transmit();
+        void handle_link_events();
+
+        void request_climate_update(uint16_t fields);
+        void change_climate(uint16_t fields);
+        void apply_group_update(const SinclairACCNT &leader, uint16_t fields);
+
+        bool follow_me_active() const;
+        void update_follow_me();
+
+        void publish_command_stats();
 
         bool reqmodechange = false;
-        unsigned char lastpacket[60];
         unsigned char lastroomtemp;
 
         bool verify_packet();
         void handle_packet();
 
-        climate::ClimateMode determine_mode();
-        const char* determine_fan_mode();
-
-        std::string determine_vertical_swing();
-        std::string determine_horizontal_swing();
+        climate::ClimateMode determine_mode(const UnitState &state);
+        climate::ClimateSwingMode determine_swing_mode(const UnitState &state);
 
-        std::string determine_display();
-        std::string determine_display_unit();
+        uint8_t determine_vertical_swing(const UnitState &state);
+        uint8_t determine_horizontal_swing(const UnitState &state);
 
-        bool determine_plasma();
-        bool determine_sleep();
-        bool determine_xfan();
-        bool determine_save();
+        uint8_t determine_display(const UnitState &state);
+        uint8_t determine_display_unit(const UnitState &state);
 };
 
 }  // namespace CNT
@@ -0,0 +1,159 @@
+#include "esppac_cnt_link.h"
+
+#include <cstring>
+
+namespace esphome {
+namespace sinclair_ac {
+namespace CNT {
+
+void UnitLink::set_mac(const uint8_t *mac) { memcpy(this->mac_, mac, sizeof(this->mac_)); }
+
+DecodeResult UnitLink::on_report(const FrameView &frame, uint32_t now, UnitState *state) {
+    DecodeResult result = decode_unit_report(frame, state);
+    if (result != DecodeResult::Ok) return result;
+
+    set_packet_from_report(frame, this->set_image_);
+    this->have_image_ = true;
+
+    if (this->state_ == ACState::Initializing) {
+        this->link_up_ = now;
+        this->handshake_step_ = HandshakeStep::MacReport;
+        this->state_ = ACState::Handshake;
+        this->events_ |= link_events::HANDSHAKE_STARTED;
+    }
+
+    if (this->command_.active &&
+        (differing_fields(*state, this->command_.expected) & this->command_.fields) == 0) {
+        this->last_latency_ = now - this->command_.first_sent;
+        this->latency_.add(this->last_latency_);
+        this->command_.active = false;
+        this->events_ |= link_events::SET_CONFIRMED;
+        if (this->first_command_time_ == 0) {
+            this->first_command_time_ = now;
+            this->events_ |= link_events::FIRST_COMMAND;
+        }
+    }
+    return result;
+}
+
+void UnitLink::check(uint32_t now, uint32_t last_received) {
+    if (this->state_ == ACState::Initializing) return;
+    if (now - last_received < protocol::TIME_TIMEOUT_INACTIVE_MS) return;
+    this->state_ = ACState::Initializing;
+    this->events_ |= link_events::LINK_LOST;
+}
+
+uint8_t UnitLink::transmit(uint32_t now, uint8_t *packet) {
+    /* nothing is sent to a unit that is not talking to us */
+    if (this->state_ == ACState::Initializing) return 0;
+
+    /* one frame per turn, the handshake before anything else, then user commands, then repeats */
+    uint8_t size;
+    if (this->state_ == ACState::Handshake) size = this->handshake_frame(now, packet);
+    else if ((size = this->flush_update(now, packet)) == 0) size = this->retry_command(now, packet);
+    if (size != 0) this->last_sent_ = now;
+    return size;
+}
+
+uint8_t UnitLink::handshake_frame(uint32_t now, uint8_t *packet) {
+    switch (this->handshake_step_) {
+        case HandshakeStep::MacReport:
+            encode_mac_report(this->mac_, packet);
+            this->handshake_step_ = HandshakeStep::InitParams;
+            return protocol::MAC_REPORT_FRAME_SIZE;
+        case HandshakeStep::InitParams:
+            encode_init_params(packet);
+            this->state_ = ACState::Ready;
+            this->events_ |= link_events::LINK_READY;
+            if (this->link_ready_time_ == 0) this->link_ready_time_ = now;
+            return protocol::INIT_PARAMS_FRAME_SIZE;
+    }
+    return 0;
+}
+
+void UnitLink::request(uint16_t fields, const UnitState &values) {
+    copy_fields(&this->requested_, values, fields);
+    this->update_fields_ |= fields;
+    this->update_requests_++;
+    this->requests_total_++;
+    this->update_pending_ = true;
+}
+
+uint8_t UnitLink::flush_update(uint32_t now, uint8_t *packet) {
+    /* the SET frame is patched into the last report, none can be built before one came in */
+    if (!this->update_pending_ || !this->have_image_) return 0;
+    /* everything requested until the refresh period expires ends up in a single SET frame */
+    if (now - this->last_sent_ < protocol::TIME_REFRESH_PERIOD_MS) return 0;
+
+    this->set_frames_total_++;
+    this->merged_requests_ = this->update_requests_;
+    this->events_ |= link_events::SET_SENT;
+    uint8_t size = this->set_frame(this->requested_, this->update_fields_, packet);
+
+    /* a newer command supersedes the one still waiting for confirmation */
+    this->command_.expected = this->requested_;
+    this->command_.fields = this->update_fields_;
+    this->command_.first_sent = now;
+    this->command_.last_sent = now;
+    this->command_.retries = 0;
+    this->command_.active = true;
+
+    this->update_pending_ = false;
+    this->update_fields_ = 0;
+    this->update_requests_ = 0;
+    return size;
+}
+
+uint8_t UnitLink::retry_command(uint32_t now, uint8_t *packet) {
+    if (!this->command_.active) return 0;
+
+    uint32_t timeout = COMMAND_ACK_TIMEOUT_MS << this->command_.retries;
+    if (timeout > COMMAND_ACK_TIMEOUT_MAX_MS) timeout = COMMAND_ACK_TIMEOUT_MAX_MS;
+    if (now - this->command_.last_sent < timeout) return 0;
+
+    if (this->command_.retries >= COMMAND_MAX_RETRIES) {
+        this->command_.active = false;
+        this->failures_total_++;
+        this->events_ |= link_events::SET_FAILED;
+        return 0;
+    }
+
+    this->command_.retries++;
+    this->retries_total_++;
+    this->command_.last_sent = now;
+    this->events_ |= link_events::SET_REPEATED;
+    return this->set_frame(this->command_.expected, this->command_.fields, packet);
+}
+
+uint8_t UnitLink::set_frame(const UnitState &state, uint16_t fields, uint8_t *packet) {
+    /* only the requested fields are written, everything else stays as the unit last reported it;
+       the beeper is a setting of this module and goes along with every frame */
+    fields |= update_fields::BEEPER;
+    FieldValues values;
+    unit_state_to_fields(state, values);
+    patch_set_packet(values, update_field_mask(fields), this->set_image_);
+    memcpy(packet, this->set_image_, protocol::SET_FRAME_SIZE);
+    return protocol::SET_FRAME_SIZE;
+}
+
+uint16_t UnitLink::pending_fields() const {
+    return this->update_fields_ | (this->command_.active ? this->command_.fields : 0);
+}
+
+void UnitLink::drop_pending(uint16_t fields, const UnitState &report) {
+    this->update_fields_ &= ~fields;
+    if (this->update_fields_ == 0) {
+        this->update_pending_ = false;
+        this->update_requests_ = 0;
+    }
+    if (this->command_.active) {
+        /* a repeat of the SET must not undo the change made on the unit */
+        this->command_.fields &= ~fields;
+        copy_fields(&this->command_.expected, report, fields);
+        if (this->command_.fields == 0) this->command_.active = false;
+    }
+}
+
+}  // namespace CNT
+}  // namespace sinclair_ac
+}  // namespace esphome
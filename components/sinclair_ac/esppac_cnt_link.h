@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esppac_cnt_protocol.h"
+#include "esppac_frame.h"
+#include "esppac_stats.h"
+
+/* This file must not depend on ESPHome, it is shared with host-side builds of the protocol core */
+
+namespace esphome {
+namespace sinclair_ac {
+namespace CNT {
+
+/* Link to the unit: the handshake is sent in the first turns after the unit starts talking, commands
+   only go out once it is done, and TIME_TIMEOUT_INACTIVE_MS without data starts over */
+enum class ACState {
+    Initializing, /* no data for quite a long time */
+    Handshake,    /* AC talking to us, MAC report and initial parameters not sent yet */
+    Ready,        /* handshake done, commands are sent */
+};
+
+/* Frames of the handshake, in the order original modules send them at power on */
+enum class HandshakeStep : uint8_t {
+    MacReport,    /* 0x04 */
+    InitParams,   /* 0x02 */
+};
+
+/* SET frames not confirmed by a unit report are repeated with a doubling timeout */
+static const uint32_t COMMAND_ACK_TIMEOUT_MS     = 1000;
+static const uint32_t COMMAND_ACK_TIMEOUT_MAX_MS = 4000;
+static const uint8_t  COMMAND_MAX_RETRIES        = 3;
+
+/* Largest frame UnitLink::transmit() produces */
+static const uint8_t LINK_FRAME_MAX = protocol::SET_FRAME_SIZE;
+
+/* Last SET frame sent, kept until a unit report shows the requested values */
+typedef struct {
+    UnitState expected;
+    uint16_t fields;      /* update_fields:: bits that were requested */
+    uint32_t first_sent;
+    uint32_t last_sent;
+    uint8_t retries;
+    bool active;
+} PendingCommand_t;
+
+/* What happened in the link since the last take_events(), for the owner to log and publish */
+namespace link_events {
+    static const uint16_t HANDSHAKE_STARTED = 1 << 0;  /* first good report while Initializing */
+    static const uint16_t LINK_READY        = 1 << 1;  /* last handshake frame handed out */
+    static const uint16_t LINK_LOST         = 1 << 2;  /* no data for TIME_TIMEOUT_INACTIVE_MS */
+    static const uint16_t SET_SENT          = 1 << 3;  /* pending requests merged into a new SET frame */
+    static const uint16_t SET_REPEATED      = 1 << 4;
+    static const uint16_t SET_CONFIRMED     = 1 << 5;  /* see last_latency() */
+    static const uint16_t SET_FAILED        = 1 << 6;  /* given up after COMMAND_MAX_RETRIES */
+    static const uint16_t FIRST_COMMAND     = 1 << 7;  /* first SET confirmed since boot */
+}
+
+/* CNT link to one unit on one half duplex line: handshake, merging of requests into SET frames and their
+   confirmation. The component and the host gateway both drive their units through it. Times are milliseconds
+   from any monotonic clock, the owner reads the line, decides when it has a turn and sends the frames
+   transmit() hands out. */
+class UnitLink {
+    public:
+        /* MAC address sent in the handshake */
+        void set_mac(const uint8_t *mac);
+
+        /* Decodes a 0x31 report. A good one becomes the base image of the next SET frames, starts the
+           handshake when the unit was silent and confirms the pending command when it shows the values. */
+        DecodeResult on_report(const FrameView &frame, uint32_t now, UnitState *state);
+
+        /* Drops the link when nothing was received since last_received for TIME_TIMEOUT_INACTIVE_MS */
+        void check(uint32_t now, uint32_t last_received);
+
+        /* Next frame for a turn the owner has, the handshake first, then a new SET once TIME_REFRESH_PERIOD_MS
+           passed since the last frame, then repeats. Returns its size, 0 when there is nothing to send. */
+        uint8_t transmit(uint32_t now, uint8_t *packet);
+
+        /* Asks for the values behind the update_fields:: bits, all requests until the next SET are merged */
+        void request(uint16_t fields, const UnitState &values);
+        /* Beeper setting sent with every SET frame */
+        void set_beeper(bool beeper) { this->requested_.beeper = beeper; }
+        /* Forgets requested fields the unit changed by itself, a repeat must not undo the change */
+        void drop_pending(uint16_t fields, const UnitState &report);
+        /* update_fields:: bits requested but not confirmed yet */
+        uint16_t pending_fields() const;
+
+        uint16_t take_events() {
+            uint16_t events = this->events_;
+            this->events_ = 0;
+            return events;
+        }
+
+        ACState state() const { return this->state_; }
+        bool ready() const { return this->state_ == ACState::Ready && this->have_image_; }
+        const UnitState &requested() const { return this->requested_; }
+        const PendingCommand_t &command() const { return this->command_; }
+        const LatencyHistogram &latency() const { return this->latency_; }
+        uint32_t last_latency() const { return this->last_latency_; }
+        uint16_t update_fields() const { return this->update_fields_; }
+        uint16_t update_requests() const { return this->update_requests_; }
+        /* change requests merged into the last SET frame sent */
+        uint16_t merged_requests() const { return this->merged_requests_; }
+        uint32_t requests_total() const { return this->requests_total_; }
+        uint32_t set_frames_total() const { return this->set_frames_total_; }
+        uint32_t retries_total() const { return this->retries_total_; }
+        uint32_t failures_total() const { return this->failures_total_; }
+        uint32_t link_up() const { return this->link_up_; }
+        uint32_t link_ready_time() const { return this->link_ready_time_; }
+        uint32_t first_command_time() const { return this->first_command_time_; }
+
+    protected:
+        uint8_t handshake_frame(uint32_t now, uint8_t *packet);
+        uint8_t flush_update(uint32_t now, uint8_t *packet);
+        uint8_t retry_command(uint32_t now, uint8_t *packet);
+        uint8_t set_frame(const UnitState &state, uint16_t fields, uint8_t *packet);
+
+        ACState state_ = ACState::Initializing;
+        HandshakeStep handshake_step_ = HandshakeStep::MacReport;  /* next handshake frame to send */
+        uint8_t mac_[6] = {};
+        uint16_t events_ = 0;                   /* link_events:: bits not taken yet */
+
+        uint8_t set_image_[protocol::SET_FRAME_SIZE];  /* SET frame built from the last unit report */
+        bool have_image_ = false;
+        uint32_t last_sent_ = 0;                /* time the last frame was handed out */
+
+        UnitState requested_{};                 /* values asked for, valid for the pending update_fields:: bits */
+        uint16_t update_fields_ = 0;            /* update_fields:: bits waiting for the next SET frame */
+        uint16_t update_requests_ = 0;          /* change requests merged into the pending SET frame */
+        bool update_pending_ = false;           /* a SET frame is due, even when no field is left to change */
+        uint16_t merged_requests_ = 0;
+
+        PendingCommand_t command_{};            /* SET frame waiting for confirmation */
+        LatencyHistogram latency_;              /* time from first SET to confirming report */
+        uint32_t last_latency_ = 0;
+
+        uint32_t requests_total_ = 0;           /* change requests since boot */
+        uint32_t set_frames_total_ = 0;         /* SET frames with new requests since boot */
+        uint32_t retries_total_ = 0;            /* SET frames repeated since boot */
+        uint32_t failures_total_ = 0;           /* SET frames never confirmed since boot */
+        uint32_t link_up_ = 0;                  /* when the unit started talking */
+        uint32_t link_ready_time_ = 0;          /* when the link first became ready, 0 before */
+        uint32_t first_command_time_ = 0;       /* when a SET was first confirmed, 0 before */
+};
+
+}  // namespace CNT
+}  // namespace sinclair_ac
+}  // namespace esphome
@@ -0,0 +1,295 @@
+#include "esppac_cnt_protocol.h"
+
+#include <cstring>
+
+#include "esppac_temperature.h"
+
+namespace esphome {
+namespace sinclair_ac {
+namespace CNT {
+
+/* Fan speed reported in REPORT_FAN_SPD1, remote controls may use the higher values for high speed */
+static constexpr uint8_t FAN_SPD1_SPEEDS[16] = {
+    FAN_SPEED_AUTO, FAN_SPEED_LOW,  FAN_SPEED_MED,  FAN_SPEED_HIGH,
+    FAN_SPEED_HIGH, FAN_SPEED_HIGH, FAN_SPEED_HIGH, FAN_SPEED_HIGH,
+    FAN_SPEED_HIGH, FAN_SPEED_HIGH, FAN_SPEED_HIGH, FAN_SPEED_HIGH,
+    FAN_SPEED_HIGH, FAN_SPEED_HIGH, FAN_SPEED_HIGH, FAN_SPEED_HIGH,
+};
+
+template<typename Layout> void Codec<Layout>::decode_fields(const uint8_t *payload, FieldValues values) {
+    /* unrolled, every field becomes a load, mask and shift with constant operands; the values still go
+       through the FieldValues array, which is most of what keeps it behind hand-written code */
+#pragma GCC unroll 32
+    for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+        const FieldDesc &desc = Layout::FIELDS[i];
+        values[i] = (payload[desc.byte] & desc.mask) >> desc.pos;
+    }
+}
+
+template<typename Layout>
+void Codec<Layout>::encode_fields(const FieldValues values, uint8_t *payload, uint8_t payload_size) {
+#pragma GCC unroll 32
+    for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+        const FieldDesc &desc = Layout::FIELDS[i];
+        if (!desc.settable || desc.byte >= payload_size) continue;
+        payload[desc.byte] = (payload[desc.byte] & ~desc.mask) | ((values[i] << desc.pos) & desc.mask);
+    }
+}
+
+void unit_state_from_fields(const FieldValues values, UnitState *state) {
+    state->power = values[FIELD_POWER];
+    state->mode = values[FIELD_MODE];
+    state->fan = values[FIELD_FAN_TURBO] ? (uint8_t) FAN_SPEED_TURBO : FAN_SPD1_SPEEDS[values[FIELD_FAN_SPD1]];
+    state->target_temperature = values[FIELD_TEMP_SET] + protocol::REPORT_TEMP_SET_OFF;
+    state->current_temperature = (values[FIELD_TEMP_ACT] - protocol::REPORT_TEMP_ACT_OFF) * 10 / protocol::REPORT_TEMP_ACT_DIV;
+    state->hswing = values[FIELD_HSWING];
+    state->vswing = values[FIELD_VSWING];
+    state->display_on = values[FIELD_DISP_ON];
+    state->display_mode = values[FIELD_DISP_MODE];
+    state->display_fahrenheit = values[FIELD_DISP_F];
+    state->temrec = values[FIELD_TEMREC];
+    state->plasma = values[FIELD_PLASMA1] | values[FIELD_PLASMA2];
+    state->sleep = values[FIELD_SLEEP];
+    state->xfan = values[FIELD_XFAN];
+    state->save = values[FIELD_SAVE];
+    state->beeper = values[FIELD_BEEPER];
+}
+
+void unit_state_to_fields(const UnitState &state, FieldValues values) {
+    memset(values, 0, sizeof(FieldValues));
+    values[FIELD_POWER] = state.power;
+    values[FIELD_MODE] = state.mode;
+    if (state.fan == FAN_SPEED_TURBO) {
+        values[FIELD_FAN_TURBO] = 1;
+        values[FIELD_FAN_SPD1] = FAN_SPEED_HIGH; // Turbo often implies high fan speed + turbo bit
+    } else {
+        values[FIELD_FAN_SPD1] = state.fan;
+    }
+    values[FIELD_TEMP_SET] = state.target_temperature - protocol::REPORT_TEMP_SET_OFF;
+    values[FIELD_HSWING] = state.hswing;
+    values[FIELD_VSWING] = state.vswing;
+    values[FIELD_DISP_ON] = state.display_on;
+    values[FIELD_DISP_MODE] = state.display_mode;
+    values[FIELD_DISP_F] = state.display_fahrenheit;
+    values[FIELD_TEMREC] = state.temrec;
+    values[FIELD_PLASMA1] = state.plasma;
+    values[FIELD_PLASMA2] = state.plasma;
+    values[FIELD_SLEEP] = state.sleep;
+    values[FIELD_XFAN] = state.xfan;
+    values[FIELD_SAVE] = state.save;
+    values[FIELD_BEEPER] = state.beeper;
+}
+
+int16_t unit_set_point(const UnitState &state) {
+    uint8_t temp_set = (state.target_temperature - protocol::REPORT_TEMP_SET_OFF) & 0x0F;
+    if (!state.display_fahrenheit) return (temp_set + protocol::REPORT_TEMP_SET_OFF) * 10;
+    return fahrenheit_to_tenths(SET_POINT_FAHRENHEIT[state.temrec][temp_set]);
+}
+
+void set_unit_set_point(UnitState *state, int16_t set_point) {
+    if (!state->display_fahrenheit) {
+        int16_t degrees = (set_point + 5) / 10;
+        if (degrees < SET_POINT_MIN_C) degrees = SET_POINT_MIN_C;
+        if (degrees > SET_POINT_MAX_C) degrees = SET_POINT_MAX_C;
+        state->target_temperature = degrees;
+        state->temrec = false;
+        return;
+    }
+    int16_t fahrenheit = tenths_to_fahrenheit(set_point);
+    if (fahrenheit < SET_POINT_MIN_F) fahrenheit = SET_POINT_MIN_F;
+    if (fahrenheit > SET_POINT_MAX_F) fahrenheit = SET_POINT_MAX_F;
+    uint8_t encoded = FAHRENHEIT_SET_POINT[fahrenheit - SET_POINT_MIN_F];
+    state->target_temperature = (encoded >> 1) + protocol::REPORT_TEMP_SET_OFF;
+    state->temrec = encoded & 1;
+}
+
+bool follow_me_applies(const UnitState &state, int16_t room) {
+    if (!state.power || room == TEMPERATURE_UNKNOWN) return false;
+    return state.mode == protocol::REPORT_MODE_COOL || state.mode == protocol::REPORT_MODE_HEAT ||
+           state.mode == protocol::REPORT_MODE_AUTO;
+}
+
+template<typename Layout> DecodeResult Codec<Layout>::decode_unit_report(const FrameView &frame, UnitState *state) {
+    if (frame.size < Layout::REPORT_MIN_SIZE) return DecodeResult::TooShort;
+    if (!frame.checksum_ok) return DecodeResult::BadChecksum;
+
+    FieldValues values;
+    decode_fields(frame.data + protocol::PAYLOAD_OFFSET, values);
+    unit_state_from_fields(values, state);
+    return DecodeResult::Ok;
+}
+
+template<typename Layout> void Codec<Layout>::encode_set_packet(const UnitState &state, uint8_t *packet) {
+    memset(packet, 0, Layout::SET_FRAME_SIZE);
+
+    packet[0] = protocol::SYNC;
+    packet[1] = protocol::SYNC;
+    packet[2] = Layout::SET_PACKET_LEN;
+    packet[3] = protocol::CMD_OUT_PARAMS_SET;
+
+    FieldValues values;
+    unit_state_to_fields(state, values);
+    encode_fields(values, packet + protocol::PAYLOAD_OFFSET, Layout::SET_PAYLOAD_SIZE);
+
+    packet[Layout::SET_FRAME_SIZE - 1] = frame_checksum(packet, Layout::SET_FRAME_SIZE);
+}
+
+template<typename Layout> void Codec<Layout>::set_packet_from_report(const FrameView &report, uint8_t *packet) {
+    packet[0] = protocol::SYNC;
+    packet[1] = protocol::SYNC;
+    packet[2] = Layout::SET_PACKET_LEN;
+    packet[3] = protocol::CMD_OUT_PARAMS_SET;
+
+    uint8_t *payload = packet + protocol::PAYLOAD_OFFSET;
+    memcpy(payload, report.data + protocol::PAYLOAD_OFFSET, Layout::SET_PAYLOAD_SIZE);
+    for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+        const FieldDesc &desc = Layout::FIELDS[i];
+        if (!desc.settable && desc.byte < Layout::SET_PAYLOAD_SIZE) payload[desc.byte] &= ~desc.mask;
+    }
+
+    packet[Layout::SET_FRAME_SIZE - 1] = frame_checksum(packet, Layout::SET_FRAME_SIZE);
+}
+
+template<typename Layout>
+void Codec<Layout>::patch_set_packet(const FieldValues values, uint32_t field_mask, uint8_t *packet) {
+    uint8_t *payload = packet + protocol::PAYLOAD_OFFSET;
+    uint8_t checksum = packet[Layout::SET_FRAME_SIZE - 1];
+    for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+        const FieldDesc &desc = Layout::FIELDS[i];
+        if (!(field_mask & field_bit((Field) i)) || !desc.settable || desc.byte >= Layout::SET_PAYLOAD_SIZE) continue;
+        uint8_t old = payload[desc.byte];
+        payload[desc.byte] = (old & ~desc.mask) | ((values[i] << desc.pos) & desc.mask);
+        checksum += payload[desc.byte] - old;
+    }
+    packet[Layout::SET_FRAME_SIZE - 1] = checksum;
+}
+
+template struct Codec<GreeLayout>;
+
+void decode_fields(const uint8_t *payload, FieldValues values) {
+    Codec<GreeLayout>::decode_fields(payload, values);
+}
+
+void encode_fields(const FieldValues values, uint8_t *payload, uint8_t payload_size) {
+    Codec<GreeLayout>::encode_fields(values, payload, payload_size);
+}
+
+DecodeResult decode_unit_report(const FrameView &frame, UnitState *state) {
+    return Codec<GreeLayout>::decode_unit_report(frame, state);
+}
+
+void encode_set_packet(const UnitState &state, uint8_t *packet) {
+    Codec<GreeLayout>::encode_set_packet(state, packet);
+}
+
+void set_packet_from_report(const FrameView &report, uint8_t *packet) {
+    Codec<GreeLayout>::set_packet_from_report(report, packet);
+}
+
+void patch_set_packet(const FieldValues values, uint32_t field_mask, uint8_t *packet) {
+    Codec<GreeLayout>::patch_set_packet(values, field_mask, packet);
+}
+
+/* protocol fields written for each update_fields:: bit, in bit order. The fan speed only owns SPD1 and
+   TURBO, SPD2 and QUIET are not part of UnitState and keep what the unit reported. */
+static const uint32_t UPDATE_FIELD_MASKS[] = {
+    field_bit(FIELD_POWER) | field_bit(FIELD_MODE),                                     /* MODE */
+    field_bit(FIELD_TEMP_SET) | field_bit(FIELD_TEMREC),                                /* TARGET_TEMP */
+    field_bit(FIELD_FAN_SPD1) | field_bit(FIELD_FAN_TURBO),                             /* FAN */
+    field_bit(FIELD_HSWING) | field_bit(FIELD_VSWING),                                  /* SWING */
+    field_bit(FIELD_HSWING),                                                            /* HSWING */
+    field_bit(FIELD_VSWING),                                                            /* VSWING */
+    field_bit(FIELD_DISP_ON) | field_bit(FIELD_DISP_MODE),                              /* DISPLAY */
+    field_bit(FIELD_DISP_F),                                                            /* DISPLAY_UNIT */
+    field_bit(FIELD_PLASMA1) | field_bit(FIELD_PLASMA2),                                /* PLASMA */
+    field_bit(FIELD_BEEPER),                                                            /* BEEPER */
+    field_bit(FIELD_SLEEP),                                                             /* SLEEP */
+    field_bit(FIELD_XFAN),                                                              /* XFAN */
+    field_bit(FIELD_SAVE),                                                              /* SAVE */
+};
+static const uint8_t UPDATE_FIELD_COUNT = sizeof(UPDATE_FIELD_MASKS) / sizeof(UPDATE_FIELD_MASKS[0]);
+static_assert(1 << (UPDATE_FIELD_COUNT - 1) == update_fields::SAVE, "UPDATE_FIELD_MASKS out of step with update_fields");
+
+uint32_t update_field_mask(uint16_t fields) {
+    uint32_t field_mask = 0;
+    for (uint8_t i = 0; i < UPDATE_FIELD_COUNT; i++) {
+        if (fields & (1 << i)) field_mask |= UPDATE_FIELD_MASKS[i];
+    }
+    return field_mask;
+}
+
+uint16_t differing_fields(const UnitState &a, const UnitState &b) {
+    uint16_t fields = 0;
+    if (a.power != b.power || (a.power && a.mode != b.mode)) fields |= update_fields::MODE;
+    if (a.target_temperature != b.target_temperature || a.temrec != b.temrec) fields |= update_fields::TARGET_TEMP;
+    if (a.fan != b.fan) fields |= update_fields::FAN;
+    if ((a.vswing == protocol::REPORT_VSWING_FULL) != (b.vswing == protocol::REPORT_VSWING_FULL) ||
+        (a.hswing == protocol::REPORT_HSWING_FULL) != (b.hswing == protocol::REPORT_HSWING_FULL))
+        fields |= update_fields::SWING;
+    if (a.hswing != b.hswing) fields |= update_fields::HSWING;
+    if (a.vswing != b.vswing) fields |= update_fields::VSWING;
+    if (a.display_on != b.display_on || (a.display_on && a.display_mode != b.display_mode))
+        fields |= update_fields::DISPLAY;
+    if (a.display_fahrenheit != b.display_fahrenheit) fields |= update_fields::DISPLAY_UNIT;
+    if (a.plasma != b.plasma) fields |= update_fields::PLASMA;
+    if (a.sleep != b.sleep) fields |= update_fields::SLEEP;
+    if (a.xfan != b.xfan) fields |= update_fields::XFAN;
+    if (a.save != b.save) fields |= update_fields::SAVE;
+    return fields;
+}
+
+void copy_fields(UnitState *dst, const UnitState &src, uint16_t fields) {
+    if (fields & update_fields::MODE) {
+        dst->power = src.power;
+        dst->mode = src.mode;
+    }
+    if (fields & update_fields::TARGET_TEMP) {
+        dst->target_temperature = src.target_temperature;
+        dst->temrec = src.temrec;
+    }
+    if (fields & update_fields::FAN) dst->fan = src.fan;
+    if (fields & (update_fields::SWING | update_fields::VSWING)) dst->vswing = src.vswing;
+    if (fields & (update_fields::SWING | update_fields::HSWING)) dst->hswing = src.hswing;
+    if (fields & update_fields::DISPLAY) {
+        dst->display_on = src.display_on;
+        dst->display_mode = src.display_mode;
+    }
+    if (fields & update_fields::DISPLAY_UNIT) dst->display_fahrenheit = src.display_fahrenheit;
+    if (fields & update_fields::PLASMA) dst->plasma = src.plasma;
+    if (fields & update_fields::BEEPER) dst->beeper = src.beeper;
+    if (fields & update_fields::SLEEP) dst->sleep = src.sleep;
+    if (fields & update_fields::XFAN) dst->xfan = src.xfan;
+    if (fields & update_fields::SAVE) dst->save = src.save;
+}
+
+void encode_mac_report(const uint8_t *mac, uint8_t *packet) {
+    memset(packet, 0, protocol::MAC_REPORT_FRAME_SIZE);
+
+    packet[0] = protocol::SYNC;
+    packet[1] = protocol::SYNC;
+    packet[2] = protocol::MAC_REPORT_LEN;
+    packet[3] = protocol::CMD_OUT_MAC_REPORT;
+
+    uint8_t *payload = packet + protocol::PAYLOAD_OFFSET;
+    payload[protocol::MAC_REPORT_CONST_BYTE] = protocol::MAC_REPORT_CONST_VAL;
+    memcpy(payload + protocol::MAC_REPORT_MAC_BYTE, mac, 6);
+
+    packet[protocol::MAC_REPORT_FRAME_SIZE - 1] = frame_checksum(packet, protocol::MAC_REPORT_FRAME_SIZE);
+}
+
+static constexpr uint8_t INIT_PARAMS_PAYLOAD[protocol::INIT_PARAMS_FRAME_SIZE - protocol::PAYLOAD_OFFSET - 1] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x28, 0x1E, 0x19, 0x23, 0x23, 0x00,
+};
+
+void encode_init_params(uint8_t *packet) {
+    packet[0] = protocol::SYNC;
+    packet[1] = protocol::SYNC;
+    packet[2] = protocol::INIT_PARAMS_LEN;
+    packet[3] = protocol::CMD_OUT_INIT_PARAMS;
+    memcpy(packet + protocol::PAYLOAD_OFFSET, INIT_PARAMS_PAYLOAD, sizeof(INIT_PARAMS_PAYLOAD));
+    packet[protocol::INIT_PARAMS_FRAME_SIZE - 1] = frame_checksum(packet, protocol::INIT_PARAMS_FRAME_SIZE);
+}
+
+}  // namespace CNT
+}  // namespace sinclair_ac
+}  // namespace esphome
@@ -0,0 +1,33 @@
+#include "esppac_follow_me.h"
+
+namespace esphome {
+namespace sinclair_ac {
+
+int32_t FollowMeController::unclamped(int16_t target, int16_t measured) const {
+    int32_t error = target - measured;
+    return target + ((error * this->kp_q8_ + this->integral_q8_) >> 8);
+}
+
+int16_t FollowMeController::output(int16_t target, int16_t measured) const {
+    int32_t set_point = this->unclamped(target, measured);
+    if (set_point < this->min_) return this->min_;
+    if (set_point > this->max_) return this->max_;
+    return set_point;
+}
+
+void FollowMeController::integrate(int16_t target, int16_t measured, uint32_t elapsed_ms) {
+    int32_t error = target - measured;
+    int32_t set_point = this->unclamped(target, measured);
+    if ((set_point >= this->max_ && error > 0) || (set_point <= this->min_ && error < 0)) return;
+    /* far from the target the room is still being pulled in, integrating that would only overshoot */
+    if (error > INTEGRATION_BAND || error < -INTEGRATION_BAND) return;
+
+    this->integral_q8_ += (int32_t) ((int64_t) error * this->ki_q8_ * elapsed_ms / 60000);
+    /* the integral alone never needs to move the set point further than across the whole range */
+    const int32_t limit = (int32_t) (this->max_ - this->min_) << 8;
+    if (this->integral_q8_ > limit) this->integral_q8_ = limit;
+    if (this->integral_q8_ < -limit) this->integral_q8_ = -limit;
+}
+
+}  // namespace sinclair_ac
+}  // namespace esphome
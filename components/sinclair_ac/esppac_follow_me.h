@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+/* This file must not depend on ESPHome, it is shared with host-side builds of the protocol core */
+
+namespace esphome {
+namespace sinclair_ac {
+
+/* PI controller that moves the set point sent to the unit so that the room, as measured by an external
+   sensor, reaches the requested temperature although the unit regulates on its own return air sensor.
+   Temperatures are in 0.1 degrees C, gains are fixed point with 8 fractional bits. */
+class FollowMeController {
+    public:
+        static const int16_t INTEGRATION_BAND = 10;  /* errors beyond this do not add to the integral */
+
+        /* kp: set point change per degree of error, ki: set point change per degree of error and minute */
+        void set_gains(uint16_t kp_q8, uint16_t ki_q8) {
+            this->kp_q8_ = kp_q8;
+            this->ki_q8_ = ki_q8;
+        }
+        void set_limits(int16_t min, int16_t max) {
+            this->min_ = min;
+            this->max_ = max;
+        }
+
+        /* Set point for the current error, without advancing the integral */
+        int16_t output(int16_t target, int16_t measured) const;
+
+        /* Advances the integral by elapsed_ms, it stops while the output sits at a limit and the error pushes
+           further into it, so the set point leaves the limit as soon as the error changes sign */
+        void integrate(int16_t target, int16_t measured, uint32_t elapsed_ms);
+
+        void reset() { this->integral_q8_ = 0; }
+
+    protected:
+        int32_t unclamped(int16_t target, int16_t measured) const;
+
+        uint16_t kp_q8_ = 256;
+        uint16_t ki_q8_ = 0;
+        int16_t min_ = 0;
+        int16_t max_ = 0;
+        int32_t integral_q8_ = 0;  /* 0.1 degrees C << 8 */
+};
+
+}  // namespace sinclair_ac
+}  // namespace esphome
@@ -0,0 +1,129 @@
+#include "esppac_frame.h"
+
+#include <cstring>
+
+namespace esphome {
+namespace sinclair_ac {
+
+bool FrameParser::feed(uint8_t c) {
+    if (this->process_.state == STATE_COMPLETE) {
+        return false;
+    }
+    if (this->process_.state == STATE_RESTART) {
+        this->reset();
+    }
+
+    switch (this->process_.state) {
+        case STATE_WAIT_SYNC:
+            /* nothing is buffered until the 7E 7E <len> header has been seen in the sliding window */
+            if (c != FRAME_SYNC && this->process_.sync_window == ((FRAME_SYNC << 8) | FRAME_SYNC)) {
+                if (c < FRAME_MIN_LEN) {
+                    this->stats_.overflows++;
+                    this->process_.sync_window = 0;
+                    break;
+                }
+                /* a clean stream has just the two sync bytes in front of the length */
+                if (this->hunt_bytes_ > 2) {
+                    this->stats_.resyncs++;
+                }
+                this->hunt_bytes_ = 0;
+                this->process_.data[0] = FRAME_SYNC;
+                this->process_.data[1] = FRAME_SYNC;
+                this->process_.data[2] = c;
+                this->process_.data_cnt = FRAME_HEADER_LEN;
+                this->process_.frame_size = c;
+                this->process_.checksum = c;
+                this->process_.state = STATE_RECIEVE;
+            } else if (this->hunt_bytes_ < UINT8_MAX) {
+                this->hunt_bytes_++;
+            }
+            this->process_.sync_window = (this->process_.sync_window << 8) | c;
+            break;
+        case STATE_RECIEVE:
+            this->process_.data[this->process_.data_cnt++] = c;
+            if (--this->process_.frame_size == 0) {
+                this->checksum_ok_ = this->process_.checksum == c;
+                this->process_.state = STATE_COMPLETE;
+                break;
+            }
+            this->process_.checksum += c;
+            if (this->process_.data_cnt == FRAME_TYPE_BYTE + 1) {
+                if (!this->accepts(c)) {
+                    this->stats_.skipped++;
+                    this->process_.state = STATE_SKIP;
+                } else if (this->process_.data[2] + FRAME_HEADER_LEN > DATA_MAX) {
+                    this->stats_.overflows++;
+                    this->reset();
+                }
+            }
+            break;
+        case STATE_SKIP:
+            if (--this->process_.frame_size == 0) {
+                this->checksum_ok_ = this->process_.checksum == c;
+                this->process_.state = STATE_COMPLETE;
+                break;
+            }
+            this->process_.checksum += c;
+            break;
+        default:
+            break;
+    }
+    if (this->process_.state != STATE_COMPLETE) return false;
+    this->stats_.frames++;
+    return true;
+}
+
+void FrameParser::accept(uint8_t type) {
+    this->accepted_[type >> 3] |= 1 << (type & 7);
+    this->filtering_ = true;
+}
+
+void FrameParser::reset() {
+    this->process_.data_cnt = 0;
+    this->process_.frame_size = 0;
+    this->process_.checksum = 0;
+    this->checksum_ok_ = false;
+    this->process_.sync_window = 0;
+    this->process_.state = STATE_WAIT_SYNC;
+}
+
+void FrameParser::abort() {
+    if (!this->in_frame()) return;
+    this->stats_.timeouts++;
+    this->reset();
+}
+
+bool FrameQueue::push(const FrameView &frame) {
+    if (this->full()) return false;
+    uint8_t slot = (this->head_ + this->count_) % FRAME_QUEUE_SIZE;
+    memcpy(this->data_[slot], frame.data, frame.size);
+    this->sizes_[slot] = frame.size;
+    this->checksum_ok_[slot] = frame.checksum_ok;
+    this->count_++;
+    return true;
+}
+
+bool FrameQueue::front(FrameView *frame) const {
+    if (this->count_ == 0) return false;
+    frame->data = this->data_[this->head_];
+    frame->size = this->sizes_[this->head_];
+    frame->checksum_ok = this->checksum_ok_[this->head_];
+    return true;
+}
+
+void FrameQueue::pop() {
+    if (this->count_ == 0) return;
+    this->head_ = (this->head_ + 1) % FRAME_QUEUE_SIZE;
+    this->count_--;
+}
+
+uint8_t frame_checksum(const uint8_t *data, size_t size) {
+    uint8_t checksum = 0;
+    for (size_t i = 2; i + 1 < size; i++) {
+        checksum += data[i];
+    }
+    return checksum;
+}
+
+}  // namespace sinclair_ac
+}  // namespace esphome
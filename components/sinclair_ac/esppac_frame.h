@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/* This file must not depend on ESPHome, it is shared with host-side builds of the protocol core */
+
+namespace esphome {
+namespace sinclair_ac {
+
+typedef enum {
+        STATE_WAIT_SYNC,
+        STATE_RECIEVE,
+        STATE_COMPLETE,
+        STATE_RESTART,
+        STATE_SKIP       /* frame type nobody handles, remaining bytes are counted but not stored */
+} SerialProcessState_t;
+
+static const uint8_t DATA_MAX = 64;      // Largest frame that is buffered, including sync, length and checksum (unit reports are 50)
+static const uint8_t FRAME_SYNC = 0x7E;
+static const uint8_t FRAME_HEADER_LEN = 3; // 0x7E 0x7E <len>, <len> counts all the bytes following it
+static const uint8_t FRAME_TYPE_BYTE = 3;
+static const uint8_t FRAME_MIN_LEN = 2;    // Smallest possible <len>: type and checksum
+
+static const uint8_t READ_TIMEOUT = 20;  // The maximum gap between two bytes of the same frame
+static const uint8_t TX_WINDOW_MS = 150; // How long after the end of a received frame the unit listens for ours
+
+/* Read-only view of a received frame, valid until the parser is fed with the next byte */
+struct FrameView {
+        const uint8_t *data;
+        uint8_t size;
+        bool checksum_ok = false;  /* checked by the parser while the bytes came in */
+
+        uint8_t operator[](uint8_t index) const { return this->data[index]; }
+        uint8_t back() const { return this->data[this->size - 1]; }
+        uint8_t type() const { return this->size > FRAME_TYPE_BYTE ? this->data[FRAME_TYPE_BYTE] : 0; }
+        /* only the header of a skipped frame is kept */
+        bool skipped() const { return this->size > 2 && this->size < this->data[2] + FRAME_HEADER_LEN; }
+};
+
+typedef struct {
+        uint8_t data[DATA_MAX];  /* statically sized frame buffer, never reallocated */
+        uint8_t data_cnt;        /* number of valid bytes in data */
+        uint8_t frame_size;      /* bytes still missing to complete the frame */
+        uint8_t checksum;        /* running sum of the bytes received after the sync bytes */
+        uint16_t sync_window;    /* last two bytes seen while waiting for sync */
+        SerialProcessState_t state;
+} SerialProcess_t;
+
+/* Parser counters since boot */
+typedef struct {
+        uint32_t frames;     /* complete frames */
+        uint32_t overflows;  /* headers dropped for an impossible length, too short or, for accepted types, longer than DATA_MAX */
+        uint32_t resyncs;    /* headers found after skipping bytes that did not belong to any frame */
+        uint32_t skipped;    /* frames of a type that is not accepted, counted in frames too */
+        uint32_t timeouts;   /* partial frames dropped after an inter-byte gap */
+} FrameStats_t;
+
+/* Byte-at-a-time parser for 7E 7E <len> framed packets, allocates nothing */
+class FrameParser {
+    public:
+        /* returns true once a complete frame is available, further bytes are refused until reset() */
+        bool feed(uint8_t c);
+        /* once a type is accepted, frames of all other types are skipped instead of buffered, so only accepted
+           types have to fit into DATA_MAX */
+        void accept(uint8_t type);
+        bool accepts(uint8_t type) const {
+            return !this->filtering_ || (this->accepted_[type >> 3] & (1 << (type & 7))) != 0;
+        }
+        bool complete() const { return this->process_.state == STATE_COMPLETE; }
+        /* true while a header has been seen but the frame is not complete yet */
+        bool in_frame() const { return this->process_.state == STATE_RECIEVE || this->process_.state == STATE_SKIP; }
+        FrameView frame() const { return FrameView{this->process_.data, this->process_.data_cnt, this->checksum_ok_}; }
+        void reset();
+        /* drops a partial frame, the caller decides when the line has been quiet for too long */
+        void abort();
+        const FrameStats_t &stats() const { return this->stats_; }
+
+    protected:
+        SerialProcess_t process_{};
+        FrameStats_t stats_{};
+        uint8_t hunt_bytes_ = 0;  /* bytes consumed while waiting for sync, saturating */
+        bool checksum_ok_ = false;
+        uint8_t accepted_[32]{};  /* bitmap of accepted frame types */
+        bool filtering_ = false;
+};
+
+static const uint8_t FRAME_QUEUE_SIZE = 3;  // Complete frames that can wait for dispatch
+
+/* Fixed ring of complete frames, decouples draining the UART from handling the frames */
+class FrameQueue {
+    public:
+        /* copies the frame, returns false when the queue is full */
+        bool push(const FrameView &frame);
+        /* oldest frame, valid until pop() */
+        bool front(FrameView *frame) const;
+        void pop();
+        uint8_t size() const { return this->count_; }
+        bool full() const { return this->count_ == FRAME_QUEUE_SIZE; }
+        bool empty() const { return this->count_ == 0; }
+
+    protected:
+        uint8_t data_[FRAME_QUEUE_SIZE][DATA_MAX];
+        uint8_t sizes_[FRAME_QUEUE_SIZE]{};
+        bool checksum_ok_[FRAME_QUEUE_SIZE]{};
+        uint8_t head_ = 0;
+        uint8_t count_ = 0;
+};
+
+/* Sum of all bytes from the length byte up to (excluding) the checksum itself */
+uint8_t frame_checksum(const uint8_t *data, size_t size);
+
+}  // namespace sinclair_ac
+}  // namespace esphome
@@ -0,0 +1,76 @@
+#include "esppac_schedule.h"
+
+#include <cstring>
+#include <strings.h>
+
+namespace esphome {
+namespace sinclair_ac {
+
+static const char *const DAY_NAMES[7] = {"sun", "mon", "tue", "wed", "thu", "fri", "sat"};
+
+bool Schedule::set(int index, const ScheduleEntry &entry) {
+    if (index < 0 || index >= SCHEDULE_MAX_ENTRIES || (entry.days & schedule_days::DAILY) == 0 || entry.minute >= MINUTES_PER_DAY)
+        return false;
+    this->entries_[index] = entry;
+    return true;
+}
+
+bool Schedule::clear(int index) {
+    if (index < 0 || index >= SCHEDULE_MAX_ENTRIES) return false;
+    memset(&this->entries_[index], 0, sizeof(ScheduleEntry));
+    return true;
+}
+
+uint8_t Schedule::count() const {
+    uint8_t count = 0;
+    for (const ScheduleEntry &entry : this->entries_) {
+        if (entry.days != 0) count++;
+    }
+    return count;
+}
+
+const ScheduleEntry *Schedule::due(uint16_t from, uint16_t to) const {
+    const uint16_t window = (to + MINUTES_PER_WEEK - from) % MINUTES_PER_WEEK;
+    const ScheduleEntry *latest = nullptr;
+    uint16_t latest_offset = 0;
+    for (const ScheduleEntry &entry : this->entries_) {
+        for (uint8_t day = 0; day < 7; day++) {
+            if (!(entry.days & (1 << day))) continue;
+            /* minutes from the start of the window to this occurrence, 0 is the minute already handled */
+            uint16_t offset = (day * MINUTES_PER_DAY + entry.minute + MINUTES_PER_WEEK - from) % MINUTES_PER_WEEK;
+            if (offset == 0 || offset > window || offset < latest_offset) continue;
+            latest = &entry;
+            latest_offset = offset;
+        }
+    }
+    return latest;
+}
+
+uint8_t parse_schedule_days(const char *days) {
+    if (strcasecmp(days, "daily") == 0) return schedule_days::DAILY;
+    if (strcasecmp(days, "weekdays") == 0) return schedule_days::WEEKDAYS;
+    if (strcasecmp(days, "weekends") == 0) return schedule_days::WEEKENDS;
+
+    uint8_t mask = 0;
+    const char *name = days;
+    while (*name != '\0') {
+        while (*name == ',' || *name == ' ') name++;
+        size_t length = strcspn(name, ", ");
+        if (length == 0) break;
+        uint8_t day = 0;
+        while (day < 7 && !(length == 3 && strncasecmp(name, DAY_NAMES[day], 3) == 0)) day++;
+        if (day == 7) return 0;
+        mask |= 1 << day;
+        name += length;
+    }
+    return mask;
+}
+
+void format_schedule_days(uint8_t days, char *out) {
+    static const char LETTERS[] = "SMTWTFS";
+    for (uint8_t day = 0; day < 7; day++) out[day] = (days & (1 << day)) ? LETTERS[day] : '-';
+    out[7] = '\0';
+}
+
+}  // namespace sinclair_ac
+}  // namespace esphome
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+
+/* This file must not depend on ESPHome, it is shared with host-side builds of the protocol core */
+
+namespace esphome {
+namespace sinclair_ac {
+
+/* Schedule times are minutes of the week counted from Sunday 00:00, like ESPHome's day_of_week */
+static const uint16_t MINUTES_PER_DAY = 24 * 60;
+static const uint16_t MINUTES_PER_WEEK = 7 * MINUTES_PER_DAY;
+
+static const uint8_t SCHEDULE_MAX_ENTRIES = 16;
+static const uint8_t SCHEDULE_KEEP = 0xFF;              /* fan or swing of an entry left as it is */
+static const int16_t SCHEDULE_TARGET_KEEP = INT16_MIN;  /* target of an entry left as it is */
+
+/* days bits, bit 0 is Sunday */
+namespace schedule_days {
+    static const uint8_t SUNDAY   = 1 << 0;
+    static const uint8_t SATURDAY = 1 << 6;
+    static const uint8_t DAILY    = 0x7F;
+    static const uint8_t WEEKENDS = SUNDAY | SATURDAY;
+    static const uint8_t WEEKDAYS = DAILY & ~WEEKENDS;
+}
+
+/* One timed change of the climate state, 8 bytes so a full table fits one flash preference */
+typedef struct {
+    uint8_t days;      /* schedule_days:: bits, 0 for an unused slot */
+    uint8_t mode;      /* climate::ClimateMode */
+    uint16_t minute;   /* minute of the day */
+    int16_t target;    /* 0.1 degrees C or SCHEDULE_TARGET_KEEP */
+    uint8_t fan;       /* fan_modes index or SCHEDULE_KEEP */
+    uint8_t swing;     /* climate::ClimateSwingMode or SCHEDULE_KEEP */
+} ScheduleEntry;
+
+/* Fixed table of entries, kept as plain data so it can be saved to and loaded from flash as is */
+class Schedule {
+    public:
+        /* False for an index out of range, an entry without days or a minute past the end of the day. The index
+           is an int as it comes from API actions, any value outside 0..SCHEDULE_MAX_ENTRIES-1 is rejected. */
+        bool set(int index, const ScheduleEntry &entry);
+        bool clear(int index);
+        const ScheduleEntry &entry(uint8_t index) const { return this->entries_[index]; }
+        uint8_t count() const;
+
+        /* Entry due last in the minutes of the week after from up to and including to, wrapping past
+           Saturday, nullptr if there is none. Of entries due at the same minute the higher index wins. */
+        const ScheduleEntry *due(uint16_t from, uint16_t to) const;
+
+    protected:
+        ScheduleEntry entries_[SCHEDULE_MAX_ENTRIES] = {};
+};
+
+/* "daily", "weekdays", "weekends" or day names separated by commas ("mon,wed,fri"), 0 if not understood */
+uint8_t parse_schedule_days(const char *days);
+/* One letter per day from Sunday, '-' for days not set, out must hold 8 bytes */
+void format_schedule_days(uint8_t days, char *out);
+
+}  // namespace sinclair_ac
+}  // namespace esphome
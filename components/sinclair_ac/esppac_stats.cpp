@@ -0,0 +1,37 @@
+#include "esppac_stats.h"
+
+namespace esphome {
+namespace sinclair_ac {
+
+/* upper bounds of the histogram buckets in ms, the last one takes everything above */
+static constexpr uint32_t LATENCY_BOUNDS[LatencyHistogram::BUCKETS] = {
+    25, 50, 75, 100, 150, 200, 300, 400, 500, 750, 1000, 1500, 2000, 3000, 5000, UINT32_MAX,
+};
+
+void LatencyHistogram::add(uint32_t value) {
+    uint8_t bucket = 0;
+    while (value > LATENCY_BOUNDS[bucket]) {
+        bucket++;
+    }
+    this->buckets_[bucket]++;
+    this->count_++;
+    if (value > this->max_) {
+        this->max_ = value;
+    }
+}
+
+uint32_t LatencyHistogram::percentile(uint8_t percent) const {
+    if (this->count_ == 0) return 0;
+    uint32_t rank = (uint32_t) (((uint64_t) this->count_ * percent + 99) / 100);
+    uint32_t seen = 0;
+    for (uint8_t bucket = 0; bucket < BUCKETS; bucket++) {
+        seen += this->buckets_[bucket];
+        if (seen >= rank) {
+            return LATENCY_BOUNDS[bucket] < this->max_ ? LATENCY_BOUNDS[bucket] : this->max_;
+        }
+    }
+    return this->max_;
+}
+
+}  // namespace sinclair_ac
+}  // namespace esphome
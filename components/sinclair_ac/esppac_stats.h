@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+/* This file must not depend on ESPHome, it is shared with host-side builds of the protocol core */
+
+namespace esphome {
+namespace sinclair_ac {
+
+/* Fixed bucket histogram of latencies in milliseconds, percentiles resolve to the bucket upper bound */
+class LatencyHistogram {
+    public:
+        static const uint8_t BUCKETS = 16;
+
+        void add(uint32_t value);
+        uint32_t percentile(uint8_t percent) const;
+        uint32_t max() const { return this->max_; }
+        uint32_t count() const { return this->count_; }
+
+    protected:
+        uint32_t buckets_[BUCKETS]{};
+        uint32_t count_ = 0;
+        uint32_t max_ = 0;
+};
+
+}  // namespace sinclair_ac
+}  // namespace esphome
@@ -0,0 +1,41 @@
+#include "esppac_temperature.h"
+
+#include <cstdlib>
+
+namespace esphome {
+namespace sinclair_ac {
+
+bool room_needs_cooling(int16_t current, int16_t target) {
+    return current != TEMPERATURE_UNKNOWN && current + TEMPERATURE_TOLERANCE >= target;
+}
+
+bool room_needs_heating(int16_t current, int16_t target) {
+    return current != TEMPERATURE_UNKNOWN && current - TEMPERATURE_TOLERANCE <= target;
+}
+
+RoomDemand room_demand(bool may_cool, bool may_heat, int16_t current, int16_t target) {
+    if (may_cool && room_needs_cooling(current, target)) return RoomDemand::Cooling;
+    if (may_heat && room_needs_heating(current, target)) return RoomDemand::Heating;
+    return RoomDemand::Idle;
+}
+
+bool temperature_differs(int16_t current, int16_t published, int16_t hysteresis) {
+    if ((current == TEMPERATURE_UNKNOWN) != (published == TEMPERATURE_UNKNOWN)) return true;
+    if (current == TEMPERATURE_UNKNOWN) return false;
+    return abs(current - published) > hysteresis;
+}
+
+int16_t TemperatureFilter::add(int16_t temperature) {
+    const uint8_t shift = this->shift_;
+    if (shift == 0) return temperature;
+    if (!this->filled_) {
+        this->sum_ = (int32_t) temperature << shift;
+        this->filled_ = true;
+    } else {
+        this->sum_ += temperature - (this->sum_ >> shift);
+    }
+    return (this->sum_ + (1 << (shift - 1))) >> shift;
+}
+
+}  // namespace sinclair_ac
+}  // namespace esphome
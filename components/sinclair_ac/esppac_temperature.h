@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+/* This file must not depend on ESPHome, it is shared with host-side builds of the protocol core */
+
+namespace esphome {
+namespace sinclair_ac {
+
+/* Temperatures below are in 0.1 degrees C, the unit used for all temperatures kept by the component */
+static const int16_t TEMPERATURE_TOLERANCE = 20;    // The tolerance to allow when checking the climate state
+static const int16_t TEMPERATURE_THRESHOLD = 1000;  // Maximum temperature the AC can report (formally 119.5 for sinclair protocol, but 100 is impossible, soo...)
+static const int16_t TEMPERATURE_UNKNOWN = INT16_MIN;
+
+/* Whether the room is warm or cold enough for the unit to be cooling or heating towards target. Both are
+   false while the room temperature is unknown, nothing is known about what the unit does then. */
+bool room_needs_cooling(int16_t current, int16_t target);
+bool room_needs_heating(int16_t current, int16_t target);
+
+/* What a unit in a mode that may cool and/or heat is doing as far as the room temperature tells, shown as the
+   climate action; cooling wins when both are allowed and the room is within tolerance of the target */
+enum class RoomDemand : uint8_t { Idle, Cooling, Heating };
+RoomDemand room_demand(bool may_cool, bool may_heat, int16_t current, int16_t target);
+
+/* Whether current differs enough from the published temperature to be worth a publish on its own: a change
+   between known and unknown always is, otherwise it has to move by more than hysteresis */
+bool temperature_differs(int16_t current, int16_t published, int16_t hysteresis);
+
+/* Exponential moving average of the reported room temperature, which moves in 0.5 degree steps and flips
+   between two of them for a while on every change. Each reading weighs 1 / 2^shift, 0 passes it through. */
+class TemperatureFilter {
+    public:
+        void set_shift(uint8_t shift) { this->shift_ = shift; }
+        int16_t add(int16_t temperature);
+
+    protected:
+        uint8_t shift_ = 2;
+        int32_t sum_ = 0;       /* temperature << shift */
+        bool filled_ = false;   /* sum_ holds a reading */
+};
+
+}  // namespace sinclair_ac
+}  // namespace esphome
@@ -0,0 +1,68 @@
+#include "esppac_trace.h"
+
+namespace esphome {
+namespace sinclair_ac {
+
+void FrameTrace::init(uint8_t *buffer, uint16_t size) {
+    this->buffer_ = buffer;
+    this->size_ = buffer != nullptr ? size : 0;
+    this->clear();
+}
+
+void FrameTrace::clear() {
+    this->head_ = 0;
+    this->used_ = 0;
+}
+
+uint8_t FrameTrace::peek(uint16_t offset) const {
+    return this->buffer_[(this->head_ + offset) % this->size_];
+}
+
+void FrameTrace::put(uint8_t value) {
+    this->buffer_[(this->head_ + this->used_) % this->size_] = value;
+    this->used_++;
+}
+
+void FrameTrace::drop_oldest() {
+    uint16_t record_size = TRACE_RECORD_HEADER + this->peek(TRACE_RECORD_HEADER - 1);
+    this->head_ = (this->head_ + record_size) % this->size_;
+    this->used_ -= record_size;
+    this->dropped_++;
+}
+
+void FrameTrace::record(uint32_t time, const uint8_t *data, uint8_t length, bool outgoing) {
+    uint16_t record_size = TRACE_RECORD_HEADER + length;
+    if (record_size > this->size_) return;
+    while (this->size_ - this->used_ < record_size) {
+        this->drop_oldest();
+    }
+
+    this->put(time);
+    this->put(time >> 8);
+    this->put(time >> 16);
+    this->put(time >> 24);
+    this->put(outgoing ? TRACE_FLAG_TX : 0);
+    this->put(length);
+    for (uint8_t i = 0; i < length; i++) {
+        this->put(data[i]);
+    }
+}
+
+bool FrameTrace::read(uint16_t *cursor, TraceRecord_t *record, uint8_t *data) const {
+    uint16_t offset = *cursor;
+    if (!this->enabled() || offset + TRACE_RECORD_HEADER > this->used_) return false;
+
+    record->time = (uint32_t) this->peek(offset) | ((uint32_t) this->peek(offset + 1) << 8) |
+                   ((uint32_t) this->peek(offset + 2) << 16) | ((uint32_t) this->peek(offset + 3) << 24);
+    record->flags = this->peek(offset + 4);
+    record->length = this->peek(offset + 5);
+    offset += TRACE_RECORD_HEADER;
+    for (uint8_t i = 0; i < record->length; i++) {
+        data[i] = this->peek(offset + i);
+    }
+    *cursor = offset + record->length;
+    return true;
+}
+
+}  // namespace sinclair_ac
+}  // namespace esphome
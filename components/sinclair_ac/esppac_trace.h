@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/* This file must not depend on ESPHome, it is shared with host-side builds of the protocol core */
+
+namespace esphome {
+namespace sinclair_ac {
+
+static const uint8_t TRACE_RECORD_HEADER = 6;  // uint32 timestamp, flags, length
+
+static const uint8_t TRACE_FLAG_TX = 0x01;
+
+/* One frame as stored in the trace */
+typedef struct {
+        uint32_t time;     /* millis() when the frame was handled */
+        uint8_t flags;     /* TRACE_FLAG_* */
+        uint8_t length;
+} TraceRecord_t;
+
+/* Binary ring of timestamped frames, oldest records are dropped when it runs full.
+ * Nothing is formatted while recording, the owner formats records when the trace is read. */
+class FrameTrace {
+    public:
+        /* buffer is owned by the caller and must outlive the trace, size 0 disables tracing */
+        void init(uint8_t *buffer, uint16_t size);
+        bool enabled() const { return this->size_ != 0; }
+
+        void record(uint32_t time, const uint8_t *data, uint8_t length, bool outgoing);
+
+        /* reads the record at *cursor (0 = oldest) into record/data and advances the cursor,
+         * data must hold 255 bytes, returns false after the newest record */
+        bool read(uint16_t *cursor, TraceRecord_t *record, uint8_t *data) const;
+
+        void clear();
+        uint32_t dropped() const { return this->dropped_; }
+
+    protected:
+        uint8_t peek(uint16_t offset) const;
+        void put(uint8_t value);
+        void drop_oldest();
+
+        uint8_t *buffer_ = nullptr;
+        uint16_t size_ = 0;
+        uint16_t head_ = 0;    /* offset of the oldest record */
+        uint16_t used_ = 0;    /* bytes in use */
+        uint32_t dropped_ = 0; /* records overwritten since boot */
+};
+
+}  // namespace sinclair_ac
+}  // namespace esphome
@@ -0,0 +1,23 @@
+// Minimal checks for the host tests: CHECK() prints the failing expression and the test exits non-zero.
+#pragma once
+
+#include <cstdio>
+
+namespace {
+
+int check_failures = 0;
+
+int check_result() {
+    if (check_failures != 0) fprintf(stderr, "%d check(s) failed\n", check_failures);
+    return check_failures == 0 ? 0 : 1;
+}
+
+}  // namespace
+
+#define CHECK(expr)                                                             \
+    do {                                                                        \
+        if (!(expr)) {                                                          \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #expr); \
+            check_failures++;                                                   \
+        }                                                                       \
+    } while (0)
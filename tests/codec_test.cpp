@@ -0,0 +1,243 @@
+// Round trips every field of the CNT codec's FIELDS table, on its own and through unit reports and SET frames.
+
+#include <cstring>
+#include <random>
+
+#include "check.h"
+#include "esppac_cnt_protocol.h"
+#include "esppac_frame.h"
+
+using namespace esphome::sinclair_ac;
+using CNT::GreeLayout;
+
+namespace {
+
+const uint8_t REPORT_PAYLOAD_SIZE = 45;
+const uint8_t REPORT_SIZE = CNT::protocol::PAYLOAD_OFFSET + REPORT_PAYLOAD_SIZE + 1;
+
+uint8_t field_max(const CNT::FieldDesc &desc) { return desc.mask >> desc.pos; }
+
+/* No two fields share a bit, so writing one can never change another */
+void test_fields_disjoint() {
+    uint8_t used[DATA_MAX] = {};
+    for (uint8_t i = 0; i < CNT::FIELD_COUNT; i++) {
+        const CNT::FieldDesc &desc = GreeLayout::FIELDS[i];
+        CHECK((used[desc.byte] & desc.mask) == 0);
+        CHECK(((desc.mask >> desc.pos) & 1) == 1);
+        used[desc.byte] |= desc.mask;
+    }
+}
+
+/* Every value of every field, alone in an otherwise empty payload, decodes to itself and to nothing else */
+void test_each_field_each_value() {
+    for (uint8_t i = 0; i < CNT::FIELD_COUNT; i++) {
+        const CNT::FieldDesc &desc = GreeLayout::FIELDS[i];
+        for (uint16_t value = 0; value <= field_max(desc); value++) {
+            uint8_t payload[DATA_MAX] = {};
+            CNT::FieldValues values = {};
+            values[i] = value;
+            CNT::encode_fields(values, payload, REPORT_PAYLOAD_SIZE);
+            /* read-only fields only ever come from the unit */
+            if (!desc.settable) {
+                CHECK(payload[desc.byte] == 0);
+                payload[desc.byte] = value << desc.pos;
+            }
+
+            CNT::FieldValues decoded;
+            CNT::decode_fields(payload, decoded);
+            for (uint8_t j = 0; j < CNT::FIELD_COUNT; j++) CHECK(decoded[j] == (j == i ? value : 0));
+        }
+    }
+}
+
+/* Random values for all fields at once survive encode and decode, bits outside the fields are left alone */
+void test_all_fields_random() {
+    std::mt19937 rng(1);
+    for (int round = 0; round < 10000; round++) {
+        CNT::FieldValues values;
+        for (uint8_t i = 0; i < CNT::FIELD_COUNT; i++) values[i] = rng() % (field_max(GreeLayout::FIELDS[i]) + 1);
+
+        uint8_t filler = rng();
+        uint8_t payload[DATA_MAX];
+        memset(payload, filler, sizeof(payload));
+        CNT::encode_fields(values, payload, REPORT_PAYLOAD_SIZE);
+
+        CNT::FieldValues decoded;
+        CNT::decode_fields(payload, decoded);
+        for (uint8_t i = 0; i < CNT::FIELD_COUNT; i++) {
+            const CNT::FieldDesc &desc = GreeLayout::FIELDS[i];
+            CHECK(decoded[i] == (desc.settable ? values[i] : (filler & desc.mask) >> desc.pos));
+        }
+
+        uint8_t used[DATA_MAX] = {};
+        for (const CNT::FieldDesc &desc : GreeLayout::FIELDS) {
+            if (desc.settable) used[desc.byte] |= desc.mask;
+        }
+        for (uint8_t byte = 0; byte < REPORT_PAYLOAD_SIZE; byte++) CHECK((payload[byte] & ~used[byte]) == (filler & ~used[byte]));
+    }
+}
+
+/* Patching every value of every settable field into a SET frame built from a report reads back the same, with
+   a valid checksum, and leaves all other fields as reported */
+void test_patch_each_field() {
+    uint8_t report[REPORT_SIZE];
+    std::mt19937 rng(2);
+    for (uint8_t &c : report) c = rng();
+    report[0] = report[1] = CNT::protocol::SYNC;
+    report[2] = REPORT_SIZE - FRAME_HEADER_LEN;
+    report[FRAME_TYPE_BYTE] = CNT::protocol::CMD_IN_UNIT_REPORT;
+    report[REPORT_SIZE - 1] = frame_checksum(report, REPORT_SIZE);
+    FrameView frame{report, REPORT_SIZE, true};
+
+    CNT::FieldValues reported;
+    CNT::decode_fields(report + CNT::protocol::PAYLOAD_OFFSET, reported);
+
+    for (uint8_t i = 0; i < CNT::FIELD_COUNT; i++) {
+        const CNT::FieldDesc &desc = GreeLayout::FIELDS[i];
+        if (!desc.settable) continue;
+        for (uint16_t value = 0; value <= field_max(desc); value++) {
+            uint8_t packet[CNT::protocol::SET_FRAME_SIZE];
+            CNT::set_packet_from_report(frame, packet);
+            CNT::FieldValues values;
+            memcpy(values, reported, sizeof(values));
+            values[i] = value;
+            CNT::patch_set_packet(values, CNT::field_bit((CNT::Field) i), packet);
+            CHECK(packet[CNT::protocol::SET_FRAME_SIZE - 1] == frame_checksum(packet, CNT::protocol::SET_FRAME_SIZE));
+
+            uint8_t payload[DATA_MAX] = {};
+            memcpy(payload, packet + CNT::protocol::PAYLOAD_OFFSET, CNT::protocol::SET_PAYLOAD_SIZE);
+            CNT::FieldValues decoded;
+            CNT::decode_fields(payload, decoded);
+            for (uint8_t j = 0; j < CNT::FIELD_COUNT; j++) {
+                if (!GreeLayout::FIELDS[j].settable) continue;
+                CHECK(decoded[j] == (j == i ? value : reported[j]));
+            }
+        }
+    }
+}
+
+/* A fan change patched into the image of a report with quiet set keeps quiet, and SPD2 as reported */
+void test_fan_patch_keeps_quiet() {
+    uint8_t report[REPORT_SIZE] = {};
+    report[0] = report[1] = CNT::protocol::SYNC;
+    report[2] = REPORT_SIZE - FRAME_HEADER_LEN;
+    report[FRAME_TYPE_BYTE] = CNT::protocol::CMD_IN_UNIT_REPORT;
+    uint8_t *payload = report + CNT::protocol::PAYLOAD_OFFSET;
+    payload[CNT::protocol::REPORT_PWR_BYTE] |= CNT::protocol::REPORT_PWR_MASK;
+    payload[CNT::protocol::REPORT_FAN_QUIET_BYTE] |= CNT::protocol::REPORT_FAN_QUIET_MASK;
+    payload[CNT::protocol::REPORT_FAN_SPD2_BYTE] |= 2 << CNT::protocol::REPORT_FAN_SPD2_POS;
+    payload[CNT::protocol::REPORT_FAN_SPD1_BYTE] |= CNT::FAN_SPEED_LOW << CNT::protocol::REPORT_FAN_SPD1_POS;
+    report[REPORT_SIZE - 1] = frame_checksum(report, REPORT_SIZE);
+    FrameView frame{report, REPORT_SIZE, true};
+
+    CNT::UnitState state;
+    CHECK(CNT::decode_unit_report(frame, &state) == CNT::DecodeResult::Ok);
+    uint8_t packet[CNT::protocol::SET_FRAME_SIZE];
+    CNT::set_packet_from_report(frame, packet);
+
+    for (uint8_t fan = CNT::FAN_SPEED_AUTO; fan <= CNT::FAN_SPEED_TURBO; fan++) {
+        state.fan = fan;
+        CNT::FieldValues values;
+        CNT::unit_state_to_fields(state, values);
+        CNT::patch_set_packet(values, CNT::update_field_mask(CNT::update_fields::FAN | CNT::update_fields::BEEPER), packet);
+        CHECK(packet[CNT::protocol::SET_FRAME_SIZE - 1] == frame_checksum(packet, CNT::protocol::SET_FRAME_SIZE));
+
+        uint8_t sent[DATA_MAX] = {};
+        memcpy(sent, packet + CNT::protocol::PAYLOAD_OFFSET, CNT::protocol::SET_PAYLOAD_SIZE);
+        CNT::FieldValues decoded;
+        CNT::decode_fields(sent, decoded);
+        CHECK(decoded[CNT::FIELD_FAN_QUIET] == 1);
+        CHECK(decoded[CNT::FIELD_FAN_SPD2] == 2);
+        CHECK(decoded[CNT::FIELD_POWER] == 1);
+        CNT::UnitState sent_state;
+        CNT::unit_state_from_fields(decoded, &sent_state);
+        CHECK(sent_state.fan == fan);
+    }
+}
+
+/* Every unit state the component can ask for comes back unchanged from a SET frame */
+void test_unit_state_round_trip() {
+    for (uint8_t mode = 0; mode <= CNT::protocol::REPORT_MODE_HEAT; mode++)
+    for (uint8_t fan = 0; fan <= CNT::FAN_SPEED_TURBO; fan++)
+    for (uint8_t temp = CNT::SET_POINT_MIN_C; temp <= CNT::SET_POINT_MAX_C; temp++)
+    for (uint8_t hswing = 0; hswing <= CNT::protocol::REPORT_HSWING_CRIGHT; hswing++)
+    for (uint8_t vswing = 0; vswing <= CNT::protocol::REPORT_VSWING_UP; vswing++) {
+        CNT::UnitState state{};
+        state.power = (mode + fan) & 1;
+        state.mode = mode;
+        state.fan = fan;
+        state.target_temperature = temp;
+        state.hswing = hswing;
+        state.vswing = vswing;
+        state.display_mode = (temp + vswing) % 4;
+
+        uint8_t packet[CNT::protocol::SET_FRAME_SIZE];
+        CNT::encode_set_packet(state, packet);
+        CHECK(packet[CNT::protocol::SET_FRAME_SIZE - 1] == frame_checksum(packet, CNT::protocol::SET_FRAME_SIZE));
+        uint8_t payload[DATA_MAX] = {};
+        memcpy(payload, packet + CNT::protocol::PAYLOAD_OFFSET, CNT::protocol::SET_PAYLOAD_SIZE);
+        CNT::FieldValues values;
+        CNT::decode_fields(payload, values);
+        CNT::UnitState decoded;
+        CNT::unit_state_from_fields(values, &decoded);
+        CHECK(decoded.power == state.power);
+        CHECK(decoded.mode == mode);
+        CHECK(decoded.fan == fan);
+        CHECK(decoded.target_temperature == temp);
+        CHECK(decoded.hswing == hswing);
+        CHECK(decoded.vswing == vswing);
+        CHECK(decoded.display_mode == state.display_mode);
+    }
+
+    for (uint16_t bits = 0; bits < 256; bits++) {
+        CNT::UnitState state{};
+        state.target_temperature = CNT::SET_POINT_MIN_C;
+        state.display_on = bits & 0x01;
+        state.display_fahrenheit = bits & 0x02;
+        state.temrec = bits & 0x04;
+        state.plasma = bits & 0x08;
+        state.sleep = bits & 0x10;
+        state.xfan = bits & 0x20;
+        state.save = bits & 0x40;
+        state.beeper = bits & 0x80;
+
+        CNT::FieldValues values;
+        CNT::unit_state_to_fields(state, values);
+        CNT::UnitState decoded;
+        CNT::unit_state_from_fields(values, &decoded);
+        CHECK(decoded.display_on == state.display_on);
+        CHECK(decoded.display_fahrenheit == state.display_fahrenheit);
+        CHECK(decoded.temrec == state.temrec);
+        CHECK(decoded.plasma == state.plasma);
+        CHECK(decoded.sleep == state.sleep);
+        CHECK(decoded.xfan == state.xfan);
+        CHECK(decoded.save == state.save);
+        CHECK(decoded.beeper == state.beeper);
+    }
+}
+
+/* The room temperature comes from the unit only, in half degrees from REPORT_TEMP_ACT_OFF */
+void test_current_temperature() {
+    for (uint16_t raw = CNT::protocol::REPORT_TEMP_ACT_OFF; raw <= 0xFF; raw++) {
+        uint8_t payload[DATA_MAX] = {};
+        payload[CNT::protocol::REPORT_TEMP_ACT_BYTE] = raw;
+        CNT::FieldValues values;
+        CNT::decode_fields(payload, values);
+        CNT::UnitState state;
+        CNT::unit_state_from_fields(values, &state);
+        CHECK(state.current_temperature == (raw - CNT::protocol::REPORT_TEMP_ACT_OFF) * 5);
+    }
+}
+
+}  // namespace
+
+int main() {
+    test_fields_disjoint();
+    test_each_field_each_value();
+    test_all_fields_random();
+    test_patch_each_field();
+    test_fan_patch_keeps_quiet();
+    test_unit_state_round_trip();
+    test_current_temperature();
+    return check_result();
+}
@@ -0,0 +1,228 @@
+// Runs CNT::UnitLink, the link engine of the component and the gateway, against the simulated unit on a
+// simulated clock.
+
+#include <cstring>
+#include <initializer_list>
+
+#include "check.h"
+#include "esppac_cnt_link.h"
+#include "esppac_cnt_protocol.h"
+#include "esppac_frame.h"
+#include "esppac_temperature.h"
+#include "sim_unit.h"
+
+using namespace esphome::sinclair_ac;
+using CNT::ACState;
+using CNT::UnitLink;
+namespace link_events = CNT::link_events;
+
+namespace {
+
+const uint8_t MAC[6] = {0x02, 0x11, 0x22, 0x33, 0x44, 0x55};
+
+CNT::UnitState report(SimUnit &sim, UnitLink &link, uint32_t now) {
+    uint8_t frame[SimUnit::REPORT_SIZE];
+    sim.build_report(frame);
+    CNT::UnitState state{};
+    CHECK(link.on_report(FrameView{frame, SimUnit::REPORT_SIZE, true}, now, &state) == CNT::DecodeResult::Ok);
+    return state;
+}
+
+/* hands the next frame of the link to the unit, returns its size */
+uint8_t turn(SimUnit &sim, UnitLink &link, uint32_t now) {
+    uint8_t packet[CNT::LINK_FRAME_MAX];
+    uint8_t size = link.transmit(now, packet);
+    if (size != 0) sim.feed(packet, size);
+    return size;
+}
+
+/* link handed both handshake frames to sim, ready at time 100 */
+void handshake(SimUnit &sim, UnitLink &link) {
+    link.set_mac(MAC);
+    report(sim, link, 100);
+    turn(sim, link, 100);
+    turn(sim, link, 100);
+    link.take_events();
+}
+
+/* Nothing goes out before the unit talks, then the MAC report, then the initial parameters, then commands */
+void test_handshake_order() {
+    SimUnit sim;
+    UnitLink link;
+    link.set_mac(MAC);
+    uint8_t packet[CNT::LINK_FRAME_MAX];
+    CHECK(link.transmit(0, packet) == 0);
+
+    CNT::UnitState values{};
+    values.target_temperature = 25;
+    link.request(CNT::update_fields::TARGET_TEMP, values);
+    report(sim, link, 1000);
+    CHECK(link.state() == ACState::Handshake);
+    CHECK(link.take_events() == link_events::HANDSHAKE_STARTED);
+
+    CHECK(link.transmit(2000, packet) == CNT::protocol::MAC_REPORT_FRAME_SIZE);
+    CHECK(packet[FRAME_TYPE_BYTE] == CNT::protocol::CMD_OUT_MAC_REPORT);
+    CHECK(memmem(packet, CNT::protocol::MAC_REPORT_FRAME_SIZE, MAC, sizeof(MAC)) != nullptr);
+    sim.feed(packet, CNT::protocol::MAC_REPORT_FRAME_SIZE);
+    CHECK(link.state() == ACState::Handshake);
+
+    CHECK(turn(sim, link, 3000) == CNT::protocol::INIT_PARAMS_FRAME_SIZE);
+    CHECK(link.state() == ACState::Ready);
+    CHECK(link.take_events() == link_events::LINK_READY);
+    CHECK(link.link_ready_time() == 3000);
+    CHECK(sim.mac_reports == 1 && sim.init_params == 1 && sim.sets == 0);
+
+    /* the request made before the handshake waits for the refresh period after the last handshake frame */
+    CHECK(turn(sim, link, 3000 + CNT::protocol::TIME_REFRESH_PERIOD_MS - 1) == 0);
+    CHECK(turn(sim, link, 3000 + CNT::protocol::TIME_REFRESH_PERIOD_MS) == CNT::protocol::SET_FRAME_SIZE);
+    CHECK(sim.sets == 1 && sim.state.target_temperature == 25);
+    CHECK(sim.bad_frames == 0);
+}
+
+/* Requests until the next turn go out in one SET frame, patched into the last report, and the report
+   showing them confirms it */
+void test_set_merged_and_confirmed() {
+    SimUnit sim;
+    sim.state.fan = CNT::FAN_SPEED_HIGH;
+    UnitLink link;
+    handshake(sim, link);
+
+    CNT::UnitState values{};
+    values.target_temperature = 18;
+    link.request(CNT::update_fields::TARGET_TEMP, values);
+    values.power = true;
+    values.mode = CNT::protocol::REPORT_MODE_HEAT;
+    link.request(CNT::update_fields::MODE, values);
+    CHECK(link.pending_fields() == (CNT::update_fields::TARGET_TEMP | CNT::update_fields::MODE));
+
+    CHECK(turn(sim, link, 1000) == CNT::protocol::SET_FRAME_SIZE);
+    CHECK(link.take_events() == link_events::SET_SENT);
+    CHECK(link.merged_requests() == 2 && link.set_frames_total() == 1 && link.requests_total() == 2);
+    CHECK(sim.sets == 1);
+    CHECK(sim.state.target_temperature == 18 && sim.state.mode == CNT::protocol::REPORT_MODE_HEAT);
+    /* fan was not requested, it stays as the unit reported it */
+    CHECK(sim.state.fan == CNT::FAN_SPEED_HIGH);
+
+    report(sim, link, 1250);
+    CHECK(link.take_events() == (link_events::SET_CONFIRMED | link_events::FIRST_COMMAND));
+    CHECK(link.last_latency() == 250);
+    CHECK(link.pending_fields() == 0);
+    CHECK(turn(sim, link, 10000) == 0);
+}
+
+/* A SET the unit never confirms is repeated after 1, 2 and 4 s and given up after another 4 s, the
+   timeout doubles up to COMMAND_ACK_TIMEOUT_MAX_MS and no further */
+void test_retry_backoff_capped() {
+    SimUnit sim;
+    UnitLink link;
+    handshake(sim, link);
+
+    CNT::UnitState values{};
+    values.target_temperature = 27;
+    link.request(CNT::update_fields::TARGET_TEMP, values);
+    uint8_t packet[CNT::LINK_FRAME_MAX];
+    CHECK(link.transmit(1000, packet) == CNT::protocol::SET_FRAME_SIZE);
+    link.take_events();
+
+    uint32_t repeats[4];
+    uint8_t count = 0;
+    uint32_t failed = 0;
+    for (uint32_t now = 1000; now <= 30000 && failed == 0; now += 10) {
+        if (link.transmit(now, packet) != 0 && count < 4) repeats[count++] = now;
+        if (link.take_events() & link_events::SET_FAILED) failed = now;
+    }
+    CHECK(count == CNT::COMMAND_MAX_RETRIES);
+    CHECK(repeats[0] == 2000 && repeats[1] == 4000 && repeats[2] == 8000);
+    CHECK(failed == 8000 + CNT::COMMAND_ACK_TIMEOUT_MAX_MS);
+    CHECK(link.retries_total() == 3 && link.failures_total() == 1);
+    CHECK(link.latency().count() == 0);
+}
+
+/* A command the unit overrode with the remote is dropped, a repeat must not undo it */
+void test_drop_pending() {
+    SimUnit sim;
+    UnitLink link;
+    handshake(sim, link);
+
+    CNT::UnitState values{};
+    values.fan = CNT::FAN_SPEED_LOW;
+    link.request(CNT::update_fields::FAN, values);
+    CHECK(turn(sim, link, 1000) == CNT::protocol::SET_FRAME_SIZE);
+
+    sim.state.fan = CNT::FAN_SPEED_TURBO;
+    CNT::UnitState remote = sim.state;
+    link.drop_pending(CNT::update_fields::FAN, remote);
+    CHECK(link.pending_fields() == 0);
+    CHECK(!link.command().active);
+    CHECK(turn(sim, link, 10000) == 0);
+    CHECK(sim.state.fan == CNT::FAN_SPEED_TURBO);
+}
+
+/* Follow me only owns the set point of a running unit in cool, heat or auto with a known room temperature,
+   in every other case a set point changed with the remote is the unit's and is taken over as reported */
+void test_follow_me_idle_set_point() {
+    SimUnit sim;
+    sim.state.power = true;
+    sim.state.mode = CNT::protocol::REPORT_MODE_DRY;
+    sim.state.target_temperature = 24;
+    UnitLink link;
+    handshake(sim, link);
+
+    sim.state.target_temperature = 28;
+    CNT::UnitState state = report(sim, link, 1000);
+    CHECK(!CNT::follow_me_applies(state, 225));
+    CHECK(CNT::unit_set_point(state) == 280);
+
+    sim.state.mode = CNT::protocol::REPORT_MODE_FAN;
+    CHECK(!CNT::follow_me_applies(report(sim, link, 2000), 225));
+    sim.state.mode = CNT::protocol::REPORT_MODE_COOL;
+    CHECK(!CNT::follow_me_applies(report(sim, link, 3000), TEMPERATURE_UNKNOWN));
+    sim.state.power = false;
+    CHECK(!CNT::follow_me_applies(report(sim, link, 4000), 225));
+
+    /* only a running unit in a regulating mode with a room temperature is steered */
+    sim.state.power = true;
+    for (uint8_t mode : {CNT::protocol::REPORT_MODE_COOL, CNT::protocol::REPORT_MODE_HEAT, CNT::protocol::REPORT_MODE_AUTO}) {
+        sim.state.mode = mode;
+        CHECK(CNT::follow_me_applies(report(sim, link, 5000), 225));
+    }
+    CHECK(link.pending_fields() == 0 && sim.sets == 0);
+}
+
+/* A silent unit drops the link, commands wait until the handshake was sent again */
+void test_link_lost() {
+    SimUnit sim;
+    UnitLink link;
+    handshake(sim, link);
+
+    link.check(100 + CNT::protocol::TIME_TIMEOUT_INACTIVE_MS - 1, 100);
+    CHECK(link.state() == ACState::Ready);
+    link.check(100 + CNT::protocol::TIME_TIMEOUT_INACTIVE_MS, 100);
+    CHECK(link.state() == ACState::Initializing);
+    CHECK(link.take_events() == link_events::LINK_LOST);
+
+    CNT::UnitState values{};
+    values.target_temperature = 20;
+    link.request(CNT::update_fields::TARGET_TEMP, values);
+    CHECK(turn(sim, link, 5000) == 0);
+
+    report(sim, link, 6000);
+    CHECK(turn(sim, link, 6000) == CNT::protocol::MAC_REPORT_FRAME_SIZE);
+    CHECK(turn(sim, link, 6000) == CNT::protocol::INIT_PARAMS_FRAME_SIZE);
+    CHECK(turn(sim, link, 6300) == CNT::protocol::SET_FRAME_SIZE);
+    CHECK(sim.mac_reports == 2 && sim.init_params == 2 && sim.state.target_temperature == 20);
+    /* the ready time is the first one since boot */
+    CHECK(link.link_ready_time() == 100);
+}
+
+}  // namespace
+
+int main() {
+    test_handshake_order();
+    test_set_merged_and_confirmed();
+    test_retry_backoff_capped();
+    test_drop_pending();
+    test_follow_me_idle_set_point();
+    test_link_lost();
+    return check_result();
+}
@@ -0,0 +1,58 @@
+// Schedule table edits as they come from API actions.
+
+#include <initializer_list>
+
+#include "check.h"
+#include "esppac_schedule.h"
+
+using namespace esphome::sinclair_ac;
+
+namespace {
+
+ScheduleEntry make_entry(uint16_t minute) {
+    ScheduleEntry entry{};
+    entry.days = schedule_days::DAILY;
+    entry.minute = minute;
+    entry.target = SCHEDULE_TARGET_KEEP;
+    entry.fan = SCHEDULE_KEEP;
+    entry.swing = SCHEDULE_KEEP;
+    return entry;
+}
+
+/* Indexes outside the table are rejected and leave every slot alone, 256 must not wrap to slot 0 */
+void test_index_out_of_range() {
+    Schedule schedule;
+    CHECK(schedule.set(0, make_entry(60)));
+    CHECK(schedule.set(SCHEDULE_MAX_ENTRIES - 1, make_entry(120)));
+
+    for (int index : {-1, -256, (int) SCHEDULE_MAX_ENTRIES, 256, 257, 65536}) {
+        CHECK(!schedule.set(index, make_entry(180)));
+        CHECK(!schedule.clear(index));
+    }
+    CHECK(schedule.count() == 2);
+    CHECK(schedule.entry(0).minute == 60);
+    CHECK(schedule.entry(1).days == 0);
+    CHECK(schedule.entry(SCHEDULE_MAX_ENTRIES - 1).minute == 120);
+
+    CHECK(schedule.clear(0));
+    CHECK(schedule.count() == 1);
+}
+
+/* Entries without days or past the end of the day are rejected */
+void test_invalid_entry() {
+    Schedule schedule;
+    ScheduleEntry entry = make_entry(MINUTES_PER_DAY);
+    CHECK(!schedule.set(0, entry));
+    entry = make_entry(0);
+    entry.days = 0;
+    CHECK(!schedule.set(0, entry));
+    CHECK(schedule.count() == 0);
+}
+
+}  // namespace
+
+int main() {
+    test_index_out_of_range();
+    test_invalid_entry();
+    return check_result();
+}
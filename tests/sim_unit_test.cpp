@@ -0,0 +1,111 @@
+// Runs the simulated unit against the parser and codec the component uses.
+
+#include <cstring>
+
+#include "check.h"
+#include "esppac_cnt_protocol.h"
+#include "esppac_frame.h"
+#include "sim_unit.h"
+
+using namespace esphome::sinclair_ac;
+
+namespace {
+
+/* The report parses as one valid frame and decodes to the state it was built from */
+void test_report_round_trip() {
+    SimUnit sim;
+    sim.state.mode = CNT::protocol::REPORT_MODE_HEAT;
+    sim.state.target_temperature = 21;
+    sim.state.current_temperature = 195;
+    sim.state.fan = 2;
+
+    uint8_t report[SimUnit::REPORT_SIZE];
+    sim.build_report(report);
+    FrameParser parser;
+    parser.accept(CNT::protocol::CMD_IN_UNIT_REPORT);
+    int frames = 0;
+    for (uint8_t c : report) {
+        if (!parser.feed(c)) continue;
+        frames++;
+        FrameView frame = parser.frame();
+        CHECK(frame.checksum_ok);
+        CNT::UnitState state;
+        CNT::decode_unit_report(frame, &state);
+        CHECK(state.power);
+        CHECK(state.mode == CNT::protocol::REPORT_MODE_HEAT);
+        CHECK(state.target_temperature == 21);
+        CHECK(state.current_temperature == 195);
+        CHECK(state.fan == 2);
+    }
+    CHECK(frames == 1);
+}
+
+/* A SET built from the report image changes the state, split over several writes and after line noise */
+void test_set_applied() {
+    SimUnit sim;
+    uint8_t report[SimUnit::REPORT_SIZE];
+    sim.build_report(report);
+    FrameView frame{report, SimUnit::REPORT_SIZE, true};
+
+    uint8_t packet[CNT::protocol::SET_FRAME_SIZE];
+    CNT::set_packet_from_report(frame, packet);
+    CNT::UnitState wanted = sim.state;
+    wanted.target_temperature = 19;
+    CNT::FieldValues values;
+    CNT::unit_state_to_fields(wanted, values);
+    CNT::patch_set_packet(values, CNT::field_bit(CNT::FIELD_TEMP_SET), packet);
+
+    const uint8_t noise[] = {0x00, 0x7E, 0x13};
+    sim.feed(noise, sizeof(noise));
+    sim.feed(packet, 10);
+    sim.feed(packet + 10, sizeof(packet) - 10);
+    CHECK(sim.sets == 1);
+    CHECK(sim.bad_frames == 0);
+    CHECK(sim.state.target_temperature == 19);
+    CHECK(sim.state.current_temperature == 260);
+
+    packet[8] ^= 0x01;
+    sim.feed(packet, sizeof(packet));
+    CHECK(sim.sets == 1);
+    CHECK(sim.bad_frames == 1);
+}
+
+/* The handshake frames are counted, not applied */
+void test_handshake_counted() {
+    SimUnit sim;
+    uint8_t mac[CNT::protocol::MAC_REPORT_FRAME_SIZE];
+    const uint8_t address[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+    CNT::encode_mac_report(address, mac);
+    uint8_t init[CNT::protocol::INIT_PARAMS_FRAME_SIZE];
+    CNT::encode_init_params(init);
+    sim.feed(mac, sizeof(mac));
+    sim.feed(init, sizeof(init));
+    CHECK(sim.mac_reports == 1);
+    CHECK(sim.init_params == 1);
+    CHECK(sim.sets == 0);
+}
+
+/* The room follows the set point while running and stays put when off */
+void test_advance() {
+    SimUnit sim;
+    sim.state.target_temperature = 24;
+    sim.state.current_temperature = 260;
+    sim.advance(4 * 60000);
+    CHECK(sim.state.current_temperature == 240);
+    sim.advance(60000);
+    CHECK(sim.state.current_temperature == 240);
+    sim.state.power = false;
+    sim.state.target_temperature = 20;
+    sim.advance(10 * 60000);
+    CHECK(sim.state.current_temperature == 240);
+}
+
+}  // namespace
+
+int main() {
+    test_report_round_trip();
+    test_set_applied();
+    test_handshake_counted();
+    test_advance();
+    return check_result();
+}
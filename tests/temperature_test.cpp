@@ -0,0 +1,90 @@
+// Room temperature handling shared by the climate action and the publish decision.
+
+#include "check.h"
+#include "esppac_temperature.h"
+
+using namespace esphome::sinclair_ac;
+
+namespace {
+
+/* An unknown room temperature asks for neither, the action shown is idle instead of heating */
+void test_unknown_room_temperature() {
+    for (int16_t target = 160; target <= 300; target += 5) {
+        CHECK(!room_needs_cooling(TEMPERATURE_UNKNOWN, target));
+        CHECK(!room_needs_heating(TEMPERATURE_UNKNOWN, target));
+    }
+}
+
+/* Known temperatures keep the tolerance on both sides of the target */
+void test_tolerance() {
+    CHECK(room_needs_cooling(230, 230 + TEMPERATURE_TOLERANCE));
+    CHECK(!room_needs_cooling(230, 230 + TEMPERATURE_TOLERANCE + 1));
+    CHECK(room_needs_heating(230, 230 - TEMPERATURE_TOLERANCE));
+    CHECK(!room_needs_heating(230, 230 - TEMPERATURE_TOLERANCE - 1));
+    /* the extremes must not overflow */
+    CHECK(room_needs_cooling(TEMPERATURE_THRESHOLD, 300));
+    CHECK(room_needs_heating(-400, 160));
+}
+
+/* The action shown follows the mode and the room: cool mode cools a warm room and idles in a cold one, heat
+   mode the other way round, heat-cool does both and an unknown room is idle whatever the mode allows */
+void test_room_demand() {
+    const int16_t target = 240;
+    CHECK(room_demand(true, false, 270, target) == RoomDemand::Cooling);
+    CHECK(room_demand(true, false, 210, target) == RoomDemand::Idle);
+    CHECK(room_demand(false, true, 210, target) == RoomDemand::Heating);
+    CHECK(room_demand(false, true, 270, target) == RoomDemand::Idle);
+    CHECK(room_demand(true, true, 270, target) == RoomDemand::Cooling);
+    CHECK(room_demand(true, true, 210, target) == RoomDemand::Heating);
+    CHECK(room_demand(true, true, target, target) == RoomDemand::Cooling);
+    CHECK(room_demand(false, false, 270, target) == RoomDemand::Idle);
+    CHECK(room_demand(false, false, 210, target) == RoomDemand::Idle);
+    for (int mode = 0; mode < 4; mode++)
+        CHECK(room_demand(mode & 1, mode & 2, TEMPERATURE_UNKNOWN, target) == RoomDemand::Idle);
+}
+
+void test_temperature_differs() {
+    CHECK(temperature_differs(225, TEMPERATURE_UNKNOWN, 10));
+    CHECK(temperature_differs(TEMPERATURE_UNKNOWN, 225, 10));
+    CHECK(!temperature_differs(TEMPERATURE_UNKNOWN, TEMPERATURE_UNKNOWN, 0));
+    CHECK(!temperature_differs(225, 225, 0));
+    CHECK(temperature_differs(226, 225, 0));
+    CHECK(!temperature_differs(235, 225, 10));
+    CHECK(temperature_differs(236, 225, 10));
+    CHECK(temperature_differs(214, 225, 10));
+}
+
+/* The first reading is taken as is, a step is followed within a few readings and a reading flipping
+   between two 0.5 degree steps settles in between instead of following every flip */
+void test_filter() {
+    TemperatureFilter pass;
+    pass.set_shift(0);
+    CHECK(pass.add(215) == 215);
+    CHECK(pass.add(220) == 220);
+
+    TemperatureFilter filter;
+    CHECK(filter.add(220) == 220);
+    int16_t value = 0;
+    for (int i = 0; i < 20; i++) value = filter.add(250);
+    CHECK(value == 250);
+
+    int16_t low = 250, high = 0;
+    for (int i = 0; i < 40; i++) {
+        value = filter.add(i % 2 ? 250 : 245);
+        if (i < 20) continue;
+        if (value < low) low = value;
+        if (value > high) high = value;
+    }
+    CHECK(low >= 245 && high <= 250 && high - low <= 2);
+}
+
+}  // namespace
+
+int main() {
+    test_unknown_room_temperature();
+    test_tolerance();
+    test_room_demand();
+    test_temperature_differs();
+    test_filter();
+    return check_result();
+}
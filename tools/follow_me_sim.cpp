@@ -0,0 +1,168 @@
+// Simulates a room with an AC unit that regulates on a return air sensor near the ceiling, with and
+// without the follow me controller, on a Linux host.
+//
+// Built by the CMakeLists.txt in the repository root:
+//   cmake -S . -B build && cmake --build build
+//
+// Usage:
+//   follow_me_sim [-k kp] [-i ki] [-t target] [-s start] [-o outside] [--strat degrees] [--heat] [--hours h]
+//
+// The room is one thermal mass losing heat to the outside. The unit runs its compressor on and off
+// around the set point with a 0.5 degree hysteresis and a minimum off time, judging the room by its
+// return air sensor, which reads the room temperature plus a stratification offset (cold air sinks,
+// warm air rises) through a two minute lag. The external sensor reads the room itself every 30 s.
+//
+// Each run is done twice: the set point sent is the target, like without follow me, and the set point
+// comes from FollowMeController every 30 s, rounded to whole degrees like a SET frame. Printed are the
+// overshoot past the target, the settling time into +-0.5 degrees of it, the mean error and the spread
+// over the second half of the run, and compressor starts per hour.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "esppac_cnt_protocol.h"
+#include "esppac_follow_me.h"
+
+using namespace esphome::sinclair_ac;
+
+namespace {
+
+/* same as FOLLOW_ME_INTERVAL_MS in esppac_cnt.h, which pulls in ESPHome */
+const uint32_t CONTROL_INTERVAL_MS = 30000;
+
+struct Options {
+    double kp = 2.0;
+    double ki = 0.1;
+    double target = 24;
+    double start = 28;
+    double outside = 32;
+    double strat = 1.5;      /* return air sensor offset while the compressor runs */
+    bool heat = false;
+    double hours = 8;
+};
+
+struct Room {
+    double outside;
+    double temperature;
+    double return_air;       /* what the unit's own sensor reads, lagging */
+    double tau_s = 3 * 3600; /* time constant towards the outside temperature */
+    double power = 6.0 / 3600;  /* degrees per second the compressor moves the room */
+    double lag_s = 120;
+};
+
+struct Unit {
+    bool heat;
+    bool running = false;
+    double stopped_at = -1e9;
+    double min_off_s = 180;
+    uint32_t starts = 0;
+};
+
+struct Result {
+    double overshoot = 0;
+    double settled_s = 0;
+    double mean_error = 0;
+    double spread = 0;
+    double starts_per_hour = 0;
+};
+
+Result run(const Options &options, bool follow_me) {
+    Room room{options.outside, options.start, options.start};
+    Unit unit{options.heat};
+    FollowMeController controller;
+    controller.set_gains((uint16_t) lround(options.kp * 256), (uint16_t) lround(options.ki * 256));
+    controller.set_limits(CNT::SET_POINT_MIN_C * 10, CNT::SET_POINT_MAX_C * 10);
+
+    const int16_t target = (int16_t) lround(options.target * 10);
+    CNT::UnitState state{};
+    CNT::set_unit_set_point(&state, target);
+    double set_point = CNT::unit_set_point(state) / 10.0;
+
+    const double duration = options.hours * 3600;
+    const double sign = options.heat ? 1 : -1;  /* direction the unit moves the room */
+    Result result;
+    bool reached = false;
+    double error_sum = 0, error_sq = 0;
+    uint32_t samples = 0;
+    for (double t = 0; t < duration; t += 1) {
+        if (follow_me && fmod(t, CONTROL_INTERVAL_MS / 1000) == 0) {
+            int16_t measured = (int16_t) lround(room.temperature * 10);
+            controller.integrate(target, measured, CONTROL_INTERVAL_MS);
+            CNT::set_unit_set_point(&state, controller.output(target, measured));
+            set_point = CNT::unit_set_point(state) / 10.0;
+        }
+
+        /* the unit's own thermostat, on the return air sensor */
+        double demand = sign * (set_point - room.return_air);
+        if (unit.running && demand < -0.5) {
+            unit.running = false;
+            unit.stopped_at = t;
+        } else if (!unit.running && demand > 0.5 && t - unit.stopped_at >= unit.min_off_s) {
+            unit.running = true;
+            unit.starts++;
+        }
+
+        room.temperature += (room.outside - room.temperature) / room.tau_s + (unit.running ? sign * room.power : 0);
+        /* the ceiling is warmer than the room, more so while the unit blows */
+        double offset = unit.running ? options.strat : options.strat / 3;
+        room.return_air += (room.temperature + offset - room.return_air) / room.lag_s;
+
+        double error = room.temperature - options.target;
+        if (!reached && sign * error >= 0) reached = true;
+        if (reached && sign * error > result.overshoot) result.overshoot = sign * error;
+        if (fabs(error) > 0.5) result.settled_s = t;
+        if (t >= duration / 2) {
+            error_sum += error;
+            error_sq += error * error;
+            samples++;
+        }
+    }
+    result.mean_error = error_sum / samples;
+    result.spread = sqrt(error_sq / samples - result.mean_error * result.mean_error);
+    result.starts_per_hour = unit.starts / options.hours;
+    return result;
+}
+
+void print(const char *name, const Result &result, const Options &options) {
+    printf("%-12s overshoot %.2f  settled %s%5.0f min  mean error %+.2f  spread %.2f  starts/h %.1f\n", name,
+           result.overshoot, result.settled_s >= options.hours * 3600 - 1 ? ">" : " ", result.settled_s / 60,
+           result.mean_error, result.spread, result.starts_per_hour);
+}
+
+int usage(const char *name) {
+    fprintf(stderr, "usage: %s [-k kp] [-i ki] [-t target] [-s start] [-o outside] [--strat degrees] [--heat]"
+                    " [--hours h]\n", name);
+    return 2;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (strcmp(arg, "--heat") == 0) {
+            options.heat = true;
+            continue;
+        }
+        if (i + 1 >= argc) return usage(argv[0]);
+        double value = atof(argv[++i]);
+        if (strcmp(arg, "-k") == 0) options.kp = value;
+        else if (strcmp(arg, "-i") == 0) options.ki = value;
+        else if (strcmp(arg, "-t") == 0) options.target = value;
+        else if (strcmp(arg, "-s") == 0) options.start = value;
+        else if (strcmp(arg, "-o") == 0) options.outside = value;
+        else if (strcmp(arg, "--strat") == 0) options.strat = value;
+        else if (strcmp(arg, "--hours") == 0) options.hours = value;
+        else return usage(argv[0]);
+    }
+
+    printf("%s to %.1f from %.1f, outside %.1f, return air offset %.1f, kp %.2f ki %.2f/min\n",
+           options.heat ? "heating" : "cooling", options.target, options.start, options.outside, options.strat,
+           options.kp, options.ki);
+    print("unit sensor", run(options, false), options);
+    print("follow me", run(options, true), options);
+    return 0;
+}
@@ -0,0 +1,194 @@
+// Compares FrameParser with the std::vector parser it replaced, on a Linux host.
+//
+// Built by the CMakeLists.txt in the repository root:
+//   cmake -S . -B build && cmake --build build
+//
+// Usage:
+//   parser_bench [-n frames] [-j junk bytes] [-r repeat]
+//
+// n unit reports from the simulated unit, each preceded by j bytes of line noise, are fed byte by byte
+// through both parsers, the way the component reads the UART. "before" is SinclairAC::read_data() as it
+// was: every byte push_back()ed into SerialProcess_t::data, the vector cleared on every resync, and the
+// frame handed on by value the way log_packet() took it. "after" is FrameParser, which hands the decoder
+// a FrameView into its fixed buffer. Reported are bytes per second (best of repeat passes) and heap
+// allocations per frame, counted by replacing the global operator new, over one pass with a new parser.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#include "esppac_cnt_protocol.h"
+#include "esppac_frame.h"
+#include "sim_unit.h"
+
+using namespace esphome::sinclair_ac;
+
+namespace {
+
+size_t allocations = 0;
+
+}  // namespace
+
+void *operator new(size_t size) {
+    allocations++;
+    void *p = malloc(size != 0 ? size : 1);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+namespace {
+
+struct Options {
+    uint32_t frames = 10000;
+    uint32_t junk = 0;
+    uint32_t repeat = 20;
+};
+
+/* keeps the compiler from dropping the work being measured */
+volatile uint32_t sink;
+
+/* The parser before user-001, taken from SinclairAC::read_data() and SinclairACCNT::processUnitReport() */
+class VectorParser {
+    public:
+        enum State { WAIT_SYNC, RECEIVE, COMPLETE, RESTART };
+
+        bool feed(uint8_t c) {
+            if (this->state_ == COMPLETE) return true;
+            if (this->state_ == RESTART) {
+                this->data_.clear();
+                this->state_ = WAIT_SYNC;
+            }
+            this->data_.push_back(c);
+            if (this->data_.size() >= DATA_MAX) {
+                this->data_.clear();
+                return false;
+            }
+            switch (this->state_) {
+                case WAIT_SYNC:
+                    if (c != FRAME_SYNC && this->data_.size() > 2 && this->data_[this->data_.size() - 2] == FRAME_SYNC &&
+                        this->data_[this->data_.size() - 3] == FRAME_SYNC) {
+                        this->data_.clear();
+                        this->data_.push_back(FRAME_SYNC);
+                        this->data_.push_back(FRAME_SYNC);
+                        this->data_.push_back(c);
+                        this->frame_size_ = c;
+                        this->state_ = RECEIVE;
+                    }
+                    break;
+                case RECEIVE:
+                    if (--this->frame_size_ == 0) this->state_ = COMPLETE;
+                    break;
+                default:
+                    break;
+            }
+            return this->state_ == COMPLETE;
+        }
+        const std::vector<uint8_t> &data() const { return this->data_; }
+        void reset() { this->state_ = RESTART; }
+
+    protected:
+        std::vector<uint8_t> data_;
+        uint8_t frame_size_ = 0;
+        State state_ = WAIT_SYNC;
+};
+
+/* log_packet() took its frame by value, the copy was made even with VERBOSE logging compiled out */
+__attribute__((noinline)) uint32_t log_packet(std::vector<uint8_t> data) { return data.size(); }
+
+uint32_t run_before(const std::vector<uint8_t> &stream) {
+    VectorParser parser;
+    uint32_t frames = 0;
+    for (uint8_t c : stream) {
+        if (!parser.feed(c)) continue;
+        const std::vector<uint8_t> &data = parser.data();
+        uint8_t checksum = 0;
+        for (size_t i = 2; i < data.size() - 1; i++) checksum += data[i];
+        if (checksum == data.back() && log_packet(data) > 0) frames++;
+        parser.reset();
+    }
+    return frames;
+}
+
+uint32_t run_after(const std::vector<uint8_t> &stream) {
+    FrameParser parser;
+    parser.accept(CNT::protocol::CMD_IN_UNIT_REPORT);
+    uint32_t frames = 0;
+    for (uint8_t c : stream) {
+        if (!parser.feed(c)) continue;
+        FrameView frame = parser.frame();
+        if (frame.checksum_ok && frame.size > 0) frames++;
+        parser.reset();
+    }
+    return frames;
+}
+
+struct Result {
+    double bytes_per_second;
+    double allocations_per_frame;
+    uint32_t frames;
+};
+
+Result measure(uint32_t (*run)(const std::vector<uint8_t> &), const std::vector<uint8_t> &stream, uint32_t repeat) {
+    Result result{};
+    size_t before = allocations;
+    result.frames = run(stream);
+    result.allocations_per_frame = result.frames > 0 ? double(allocations - before) / result.frames : 0;
+
+    double best = 1e9;
+    for (uint32_t i = 0; i < repeat; i++) {
+        auto start = std::chrono::steady_clock::now();
+        sink = run(stream);
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (elapsed < best) best = elapsed;
+    }
+    result.bytes_per_second = stream.size() / best;
+    return result;
+}
+
+int usage(const char *name) {
+    fprintf(stderr, "usage: %s [-n frames] [-j junk bytes] [-r repeat]\n", name);
+    return 2;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) return usage(argv[0]);
+        uint32_t value = strtoul(argv[++i], nullptr, 10);
+        if (strcmp(argv[i - 1], "-n") == 0) options.frames = value;
+        else if (strcmp(argv[i - 1], "-j") == 0) options.junk = value;
+        else if (strcmp(argv[i - 1], "-r") == 0) options.repeat = value;
+        else return usage(argv[0]);
+    }
+    if (options.frames == 0 || options.repeat == 0) return usage(argv[0]);
+
+    std::vector<uint8_t> stream;
+    SimUnit sim;
+    for (uint32_t i = 0; i < options.frames; i++) {
+        for (uint32_t j = 0; j < options.junk; j++) stream.push_back((uint8_t) (0x11 * (i + j)) | 0x01);
+        sim.state.target_temperature = 16 + i % 15;
+        sim.state.fan = i % CNT::FAN_SPEED_TURBO;
+        uint8_t report[SimUnit::REPORT_SIZE];
+        sim.build_report(report);
+        stream.insert(stream.end(), report, report + sizeof(report));
+    }
+
+    Result before = measure(run_before, stream, options.repeat);
+    Result after = measure(run_after, stream, options.repeat);
+    printf("%u reports, %u junk bytes each, %zu bytes, best of %u passes\n", options.frames, options.junk,
+           stream.size(), options.repeat);
+    printf("%-8s %10s %12s %10s\n", "", "MB/s", "allocs/frame", "frames");
+    printf("%-8s %10.1f %12.3f %10u\n", "before", before.bytes_per_second / 1e6, before.allocations_per_frame,
+           before.frames);
+    printf("%-8s %10.1f %12.3f %10u\n", "after", after.bytes_per_second / 1e6, after.allocations_per_frame,
+           after.frames);
+    return 0;
+}
@@ -0,0 +1,264 @@
+// Measures the protocol core on a Linux host: parser throughput, unit report decode and SET encode time.
+//
+// Built by the CMakeLists.txt in the repository root:
+//   cmake -S . -B build && cmake --build build
+//
+// Usage:
+//   protocol_bench [-n frames] [-r repeat]
+//
+// n unit reports with varying states are generated by the simulated unit. Reported are the parser's
+// throughput over the concatenated stream, the time per decode_unit_report() call, and per SET frame
+// built from scratch with encode_set_packet() or by patching one field into the last report image with
+// patch_set_packet(), the way the component builds them. Decode and encode are also timed through the
+// hand-written code the FIELDS table replaced, one line per field as before user-005, extended to every
+// field so that both paths produce the same state and frame. Every figure is the best of repeat passes.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "esppac_cnt_protocol.h"
+#include "esppac_frame.h"
+#include "sim_unit.h"
+
+using namespace esphome::sinclair_ac;
+
+namespace {
+
+struct Options {
+    uint32_t frames = 10000;
+    uint32_t repeat = 20;
+};
+
+/* keeps the compiler from dropping the work being measured */
+volatile uint32_t sink;
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template<typename F> double best_of(uint32_t repeat, F pass) {
+    double best = 1e9;
+    for (uint32_t i = 0; i < repeat; i++) {
+        auto start = std::chrono::steady_clock::now();
+        pass();
+        double elapsed = seconds_since(start);
+        if (elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+/* The codec as it was written before the FIELDS table */
+namespace hand_written {
+
+using namespace CNT;
+
+DecodeResult decode_unit_report(const FrameView &frame, UnitState *state) {
+    if (frame.size < protocol::REPORT_MIN_SIZE) return DecodeResult::TooShort;
+    if (!frame.checksum_ok) return DecodeResult::BadChecksum;
+
+    const uint8_t *payload = frame.data + protocol::PAYLOAD_OFFSET;
+
+    state->power = (payload[protocol::REPORT_PWR_BYTE] & protocol::REPORT_PWR_MASK) != 0;
+    state->mode = (payload[protocol::REPORT_MODE_BYTE] & protocol::REPORT_MODE_MASK) >> protocol::REPORT_MODE_POS;
+
+    uint8_t temp_raw = (payload[protocol::REPORT_TEMP_SET_BYTE] & protocol::REPORT_TEMP_SET_MASK) >> protocol::REPORT_TEMP_SET_POS;
+    state->target_temperature = temp_raw + protocol::REPORT_TEMP_SET_OFF;
+
+    uint8_t curr_temp_raw = payload[protocol::REPORT_TEMP_ACT_BYTE];
+    state->current_temperature = (curr_temp_raw - protocol::REPORT_TEMP_ACT_OFF) * 10 / protocol::REPORT_TEMP_ACT_DIV;
+
+    uint8_t fan_speed = (payload[protocol::REPORT_FAN_SPD1_BYTE] & protocol::REPORT_FAN_SPD1_MASK) >> protocol::REPORT_FAN_SPD1_POS;
+    if (payload[protocol::REPORT_FAN_TURBO_BYTE] & protocol::REPORT_FAN_TURBO_MASK) state->fan = FAN_SPEED_TURBO;
+    else state->fan = fan_speed > FAN_SPEED_HIGH ? (uint8_t) FAN_SPEED_HIGH : fan_speed;
+
+    state->hswing = (payload[protocol::REPORT_HSWING_BYTE] & protocol::REPORT_HSWING_MASK) >> protocol::REPORT_HSWING_POS;
+    state->vswing = (payload[protocol::REPORT_VSWING_BYTE] & protocol::REPORT_VSWING_MASK) >> protocol::REPORT_VSWING_POS;
+    state->display_on = (payload[protocol::REPORT_DISP_ON_BYTE] & protocol::REPORT_DISP_ON_MASK) != 0;
+    state->display_mode = (payload[protocol::REPORT_DISP_MODE_BYTE] & protocol::REPORT_DISP_MODE_MASK) >> protocol::REPORT_DISP_MODE_POS;
+    state->display_fahrenheit = (payload[protocol::REPORT_DISP_F_BYTE] & protocol::REPORT_DISP_F_MASK) != 0;
+    state->temrec = (payload[protocol::REPORT_DISP_F_BYTE] & protocol::TEMREC_MASK) != 0;
+    state->plasma = (payload[protocol::REPORT_PLASMA1_BYTE] & protocol::REPORT_PLASMA1_MASK) != 0 ||
+                    (payload[protocol::REPORT_PLASMA2_BYTE] & protocol::REPORT_PLASMA2_MASK) != 0;
+    state->sleep = (payload[protocol::REPORT_SLEEP_BYTE] & protocol::REPORT_SLEEP_MASK) != 0;
+    state->xfan = (payload[protocol::REPORT_XFAN_BYTE] & protocol::REPORT_XFAN_MASK) != 0;
+    state->save = (payload[protocol::REPORT_SAVE_BYTE] & protocol::REPORT_SAVE_MASK) != 0;
+    state->beeper = (payload[protocol::REPORT_BEEPER_BYTE] & protocol::REPORT_BEEPER_MASK) != 0;
+
+    return DecodeResult::Ok;
+}
+
+void encode_set_packet(const UnitState &state, uint8_t *packet) {
+    memset(packet, 0, protocol::SET_FRAME_SIZE);
+
+    packet[0] = protocol::SYNC;
+    packet[1] = protocol::SYNC;
+    packet[2] = protocol::SET_PACKET_LEN;
+    packet[3] = protocol::CMD_OUT_PARAMS_SET;
+
+    uint8_t *payload = packet + protocol::PAYLOAD_OFFSET;
+
+    if (state.power) payload[protocol::REPORT_PWR_BYTE] |= protocol::REPORT_PWR_MASK;
+    payload[protocol::REPORT_MODE_BYTE] |= (state.mode << protocol::REPORT_MODE_POS) & protocol::REPORT_MODE_MASK;
+
+    payload[protocol::REPORT_TEMP_SET_BYTE] |=
+        ((state.target_temperature - protocol::REPORT_TEMP_SET_OFF) << protocol::REPORT_TEMP_SET_POS) & protocol::REPORT_TEMP_SET_MASK;
+
+    uint8_t fan_speed = state.fan;
+    if (state.fan == FAN_SPEED_TURBO) {
+        payload[protocol::REPORT_FAN_TURBO_BYTE] |= protocol::REPORT_FAN_TURBO_MASK;
+        fan_speed = FAN_SPEED_HIGH;
+    }
+    payload[protocol::REPORT_FAN_SPD1_BYTE] |= (fan_speed << protocol::REPORT_FAN_SPD1_POS) & protocol::REPORT_FAN_SPD1_MASK;
+
+    payload[protocol::REPORT_VSWING_BYTE] |= (state.vswing << protocol::REPORT_VSWING_POS) & protocol::REPORT_VSWING_MASK;
+    payload[protocol::REPORT_HSWING_BYTE] |= (state.hswing << protocol::REPORT_HSWING_POS) & protocol::REPORT_HSWING_MASK;
+
+    if (state.display_on) payload[protocol::REPORT_DISP_ON_BYTE] |= protocol::REPORT_DISP_ON_MASK;
+    payload[protocol::REPORT_DISP_MODE_BYTE] |= (state.display_mode << protocol::REPORT_DISP_MODE_POS) & protocol::REPORT_DISP_MODE_MASK;
+    if (state.display_fahrenheit) payload[protocol::REPORT_DISP_F_BYTE] |= protocol::REPORT_DISP_F_MASK;
+    if (state.temrec) payload[protocol::REPORT_DISP_F_BYTE] |= protocol::TEMREC_MASK;
+    if (state.plasma) {
+        payload[protocol::REPORT_PLASMA1_BYTE] |= protocol::REPORT_PLASMA1_MASK;
+        payload[protocol::REPORT_PLASMA2_BYTE] |= protocol::REPORT_PLASMA2_MASK;
+    }
+    if (state.sleep) payload[protocol::REPORT_SLEEP_BYTE] |= protocol::REPORT_SLEEP_MASK;
+    if (state.xfan) payload[protocol::REPORT_XFAN_BYTE] |= protocol::REPORT_XFAN_MASK;
+    if (state.save) payload[protocol::REPORT_SAVE_BYTE] |= protocol::REPORT_SAVE_MASK;
+    if (state.beeper) payload[protocol::REPORT_BEEPER_BYTE] |= protocol::REPORT_BEEPER_MASK;
+
+    packet[protocol::SET_FRAME_SIZE - 1] = frame_checksum(packet, protocol::SET_FRAME_SIZE);
+}
+
+}  // namespace hand_written
+
+std::vector<CNT::UnitState> generate_states(uint32_t frames) {
+    std::vector<CNT::UnitState> states;
+    SimUnit sim;
+    for (uint32_t i = 0; i < frames; i++) {
+        CNT::UnitState &state = sim.state;
+        state.mode = i % 5;
+        state.fan = i % CNT::FAN_SPEED_TURBO;
+        state.target_temperature = 16 + i % 15;
+        state.current_temperature = 200 + (i % 20) * 5;
+        state.vswing = i % 12;
+        state.hswing = i % 7;
+        state.plasma = i & 1;
+        state.sleep = i & 2;
+        states.push_back(state);
+    }
+    return states;
+}
+
+int usage(const char *name) {
+    fprintf(stderr, "usage: %s [-n frames] [-r repeat]\n", name);
+    return 2;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) return usage(argv[0]);
+        uint32_t value = strtoul(argv[++i], nullptr, 10);
+        if (strcmp(argv[i - 1], "-n") == 0) options.frames = value;
+        else if (strcmp(argv[i - 1], "-r") == 0) options.repeat = value;
+        else return usage(argv[0]);
+    }
+    if (options.frames == 0 || options.repeat == 0) return usage(argv[0]);
+
+    std::vector<CNT::UnitState> states = generate_states(options.frames);
+    std::vector<uint8_t> stream;
+    std::vector<std::vector<uint8_t>> reports;
+    SimUnit sim;
+    for (const CNT::UnitState &state : states) {
+        sim.state = state;
+        uint8_t frame[SimUnit::REPORT_SIZE];
+        sim.build_report(frame);
+        reports.emplace_back(frame, frame + sizeof(frame));
+        stream.insert(stream.end(), frame, frame + sizeof(frame));
+    }
+
+    double parse = best_of(options.repeat, [&]() {
+        FrameParser parser;
+        parser.accept(CNT::protocol::CMD_IN_UNIT_REPORT);
+        uint32_t frames = 0;
+        for (uint8_t c : stream) {
+            if (!parser.feed(c)) continue;
+            frames++;
+            parser.reset();
+        }
+        sink = frames;
+    });
+
+    auto time_decode = [&](CNT::DecodeResult (*decode)(const FrameView &, CNT::UnitState *)) {
+        return best_of(options.repeat, [&]() {
+            uint32_t sum = 0;
+            for (const auto &report : reports) {
+                FrameView frame{report.data(), (uint8_t) report.size(), true};
+                CNT::UnitState state;
+                decode(frame, &state);
+                sum += state.target_temperature + state.fan + state.beeper;
+            }
+            sink = sum;
+        });
+    };
+    auto time_encode = [&](void (*encode)(const CNT::UnitState &, uint8_t *)) {
+        return best_of(options.repeat, [&]() {
+            uint8_t packet[CNT::protocol::SET_FRAME_SIZE];
+            uint32_t sum = 0;
+            for (const CNT::UnitState &state : states) {
+                encode(state, packet);
+                sum += packet[CNT::protocol::SET_FRAME_SIZE - 1];
+            }
+            sink = sum;
+        });
+    };
+    double decode = time_decode(CNT::decode_unit_report);
+    double decode_hand = time_decode(hand_written::decode_unit_report);
+    double encode = time_encode(CNT::encode_set_packet);
+    double encode_hand = time_encode(hand_written::encode_set_packet);
+
+    /* both paths have to agree before their times mean anything */
+    for (size_t i = 0; i < reports.size(); i++) {
+        FrameView frame{reports[i].data(), (uint8_t) reports[i].size(), true};
+        CNT::UnitState table{}, hand{};
+        CNT::decode_unit_report(frame, &table);
+        hand_written::decode_unit_report(frame, &hand);
+        uint8_t table_packet[CNT::protocol::SET_FRAME_SIZE], hand_packet[CNT::protocol::SET_FRAME_SIZE];
+        CNT::encode_set_packet(states[i], table_packet);
+        hand_written::encode_set_packet(states[i], hand_packet);
+        if (memcmp(&table, &hand, sizeof(table)) != 0 || memcmp(table_packet, hand_packet, sizeof(table_packet)) != 0) {
+            fprintf(stderr, "table and hand-written codec disagree on report %zu\n", i);
+            return 1;
+        }
+    }
+
+    uint8_t image[CNT::protocol::SET_FRAME_SIZE];
+    FrameView first{reports[0].data(), (uint8_t) reports[0].size(), true};
+    CNT::set_packet_from_report(first, image);
+    double patch = best_of(options.repeat, [&]() {
+        uint32_t sum = 0;
+        for (const CNT::UnitState &state : states) {
+            CNT::FieldValues values;
+            CNT::unit_state_to_fields(state, values);
+            CNT::patch_set_packet(values, CNT::field_bit(CNT::FIELD_TEMP_SET), image);
+            sum += image[CNT::protocol::SET_FRAME_SIZE - 1];
+        }
+        sink = sum;
+    });
+
+    const double n = options.frames;
+    printf("%u reports, %zu bytes, best of %u passes\n", options.frames, stream.size(), options.repeat);
+    printf("parse   %8.1f MB/s  %6.1f ns/byte  %7.1f ns/frame\n", stream.size() / parse / 1e6,
+           parse * 1e9 / stream.size(), parse * 1e9 / n);
+    printf("decode  %7.1f ns/report (FIELDS table)  %7.1f ns/report (hand-written)\n", decode * 1e9 / n,
+           decode_hand * 1e9 / n);
+    printf("encode  %7.1f ns/SET (FIELDS table)     %7.1f ns/SET (hand-written)\n", encode * 1e9 / n,
+           encode_hand * 1e9 / n);
+    printf("patch   %7.1f ns/SET (one field into the report image)\n", patch * 1e9 / n);
+    return 0;
+}
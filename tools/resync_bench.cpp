@@ -0,0 +1,233 @@
+// Measures how FrameParser recovers from line noise, on a Linux host.
+//
+// Built by the CMakeLists.txt in the repository root:
+//   cmake -S . -B build && cmake --build build
+//
+// Usage:
+//   resync_bench [-n frames] [-b bitflip] [-x drop] [-u duplicate] [-s sync] [-t truncate]
+//                [-r repeat] [--seed n] [--no-gap-abort]
+//
+// A stream of unit reports is generated, each followed by a pause on the line, and corrupted with
+// the given rates: bit flips, dropped bytes, duplicated bytes and spurious 0x7E bytes are per byte,
+// truncation is per frame and cuts the frame at a random point. The stream is fed through the
+// parser the way the component does it, partial frames are dropped at every pause unless
+// --no-gap-abort is given. Reported are frames lost per injected error, the bytes from an error to
+// the start of the next good frame, and parser plus decoder throughput over repeat passes.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "esppac_cnt_protocol.h"
+#include "esppac_frame.h"
+
+using namespace esphome::sinclair_ac;
+
+namespace {
+
+const uint8_t REPORT_LEN = 0x2F;  /* type, 45 payload bytes, checksum */
+const uint8_t REPORT_SIZE = REPORT_LEN + FRAME_HEADER_LEN;
+/* payload bytes not used by any field, they carry the frame number */
+const uint8_t SEQ_BYTE = 30;
+
+struct Options {
+    uint32_t frames = 10000;
+    double bitflip = 0;
+    double drop = 0;
+    double duplicate = 0;
+    double sync = 0;
+    double truncate = 0;
+    uint32_t repeat = 20;
+    uint32_t seed = 1;
+    bool gap_abort = true;
+};
+
+struct Stream {
+    std::vector<uint8_t> bytes;
+    std::vector<size_t> gaps;    /* offsets that follow a pause on the line */
+    std::vector<size_t> errors;  /* offsets of injected errors, ascending */
+    uint32_t injected[5] = {};
+};
+
+enum { ERR_BITFLIP, ERR_DROP, ERR_DUPLICATE, ERR_SYNC, ERR_TRUNCATE };
+const char *const ERROR_NAMES[] = {"bit flips", "dropped", "duplicated", "spurious 7E", "truncated"};
+
+void build_report(uint32_t seq, uint8_t *frame) {
+    memset(frame, 0, REPORT_SIZE);
+    frame[0] = FRAME_SYNC;
+    frame[1] = FRAME_SYNC;
+    frame[2] = REPORT_LEN;
+    frame[3] = CNT::protocol::CMD_IN_UNIT_REPORT;
+
+    CNT::UnitState state{};
+    state.power = true;
+    state.mode = CNT::protocol::REPORT_MODE_COOL;
+    state.fan = seq % CNT::FAN_SPEED_TURBO;
+    state.target_temperature = 16 + seq % 15;
+    CNT::FieldValues values;
+    CNT::unit_state_to_fields(state, values);
+    uint8_t *payload = frame + CNT::protocol::PAYLOAD_OFFSET;
+    CNT::encode_fields(values, payload, REPORT_SIZE - CNT::protocol::PAYLOAD_OFFSET - 1);
+    payload[SEQ_BYTE] = seq >> 16;
+    payload[SEQ_BYTE + 1] = seq >> 8;
+    payload[SEQ_BYTE + 2] = seq;
+    frame[REPORT_SIZE - 1] = frame_checksum(frame, REPORT_SIZE);
+}
+
+Stream generate(const Options &options, std::vector<std::vector<uint8_t>> *originals) {
+    std::mt19937 rng(options.seed);
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+    Stream stream;
+    uint8_t frame[REPORT_SIZE];
+
+    for (uint32_t seq = 0; seq < options.frames; seq++) {
+        build_report(seq, frame);
+        originals->emplace_back(frame, frame + REPORT_SIZE);
+        stream.gaps.push_back(stream.bytes.size());
+
+        uint8_t size = REPORT_SIZE;
+        if (chance(rng) < options.truncate) {
+            size = 1 + rng() % (REPORT_SIZE - 1);
+            stream.errors.push_back(stream.bytes.size() + size);
+            stream.injected[ERR_TRUNCATE]++;
+        }
+        for (uint8_t i = 0; i < size; i++) {
+            uint8_t c = frame[i];
+            if (chance(rng) < options.sync) {
+                stream.errors.push_back(stream.bytes.size());
+                stream.bytes.push_back(FRAME_SYNC);
+                stream.injected[ERR_SYNC]++;
+            }
+            if (chance(rng) < options.drop) {
+                stream.errors.push_back(stream.bytes.size());
+                stream.injected[ERR_DROP]++;
+                continue;
+            }
+            if (chance(rng) < options.bitflip) {
+                c ^= 1 << (rng() % 8);
+                stream.errors.push_back(stream.bytes.size());
+                stream.injected[ERR_BITFLIP]++;
+            }
+            stream.bytes.push_back(c);
+            if (chance(rng) < options.duplicate) {
+                stream.errors.push_back(stream.bytes.size());
+                stream.bytes.push_back(c);
+                stream.injected[ERR_DUPLICATE]++;
+            }
+        }
+    }
+    return stream;
+}
+
+struct Result {
+    uint32_t good = 0;         /* decoded and identical to the frame that was sent */
+    uint32_t corrupted = 0;    /* decoded, but not what was sent */
+    std::vector<size_t> good_starts;
+};
+
+Result parse(const Stream &stream, const std::vector<std::vector<uint8_t>> &originals, bool gap_abort, bool collect) {
+    FrameParser parser;
+    parser.accept(CNT::protocol::CMD_IN_UNIT_REPORT);
+    Result result;
+    size_t gap = 0;
+    for (size_t i = 0; i < stream.bytes.size(); i++) {
+        if (gap < stream.gaps.size() && stream.gaps[gap] == i) {
+            if (gap_abort) parser.abort();
+            gap++;
+        }
+        if (!parser.feed(stream.bytes[i])) continue;
+        const FrameView frame = parser.frame();
+        CNT::UnitState state;
+        if (!frame.skipped() && CNT::decode_unit_report(frame, &state) == CNT::DecodeResult::Ok) {
+            const uint8_t *payload = frame.data + CNT::protocol::PAYLOAD_OFFSET;
+            uint32_t seq = (payload[SEQ_BYTE] << 16) | (payload[SEQ_BYTE + 1] << 8) | payload[SEQ_BYTE + 2];
+            if (seq < originals.size() && frame.size == originals[seq].size() &&
+                memcmp(frame.data, originals[seq].data(), frame.size) == 0) {
+                result.good++;
+                if (collect) result.good_starts.push_back(i + 1 - frame.size);
+            } else {
+                result.corrupted++;
+            }
+        }
+        parser.reset();
+    }
+    return result;
+}
+
+int usage(const char *name) {
+    fprintf(stderr, "usage: %s [-n frames] [-b bitflip] [-x drop] [-u duplicate] [-s sync] [-t truncate]\n"
+                    "       [-r repeat] [--seed n] [--no-gap-abort]\n", name);
+    return 2;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (strcmp(arg, "--no-gap-abort") == 0) {
+            options.gap_abort = false;
+            continue;
+        }
+        if (value == nullptr) return usage(argv[0]);
+        i++;
+        /* a mistyped option would otherwise run a clean benchmark and look like a result */
+        if (strcmp(arg, "-n") == 0) options.frames = strtoul(value, nullptr, 10);
+        else if (strcmp(arg, "-b") == 0) options.bitflip = atof(value);
+        else if (strcmp(arg, "-x") == 0) options.drop = atof(value);
+        else if (strcmp(arg, "-u") == 0) options.duplicate = atof(value);
+        else if (strcmp(arg, "-s") == 0) options.sync = atof(value);
+        else if (strcmp(arg, "-t") == 0) options.truncate = atof(value);
+        else if (strcmp(arg, "-r") == 0) options.repeat = strtoul(value, nullptr, 10);
+        else if (strcmp(arg, "--seed") == 0) options.seed = strtoul(value, nullptr, 10);
+        else return usage(argv[0]);
+    }
+
+    std::vector<std::vector<uint8_t>> originals;
+    Stream stream = generate(options, &originals);
+    Result result = parse(stream, originals, options.gap_abort, true);
+
+    uint32_t errors = 0;
+    printf("%u frames, %zu bytes, injected:", options.frames, stream.bytes.size());
+    for (int i = 0; i <= ERR_TRUNCATE; i++) {
+        printf(" %u %s%s", stream.injected[i], ERROR_NAMES[i], i < ERR_TRUNCATE ? "," : "\n");
+        errors += stream.injected[i];
+    }
+    uint32_t lost = options.frames - result.good;
+    printf("good %u, lost %u, corrupted but accepted %u, frames lost per error %.2f\n", result.good, lost,
+           result.corrupted, errors ? (double) lost / errors : 0.0);
+
+    /* bytes from each error to the start of the first good frame after it */
+    std::vector<size_t> resync;
+    size_t next = 0;
+    for (size_t error : stream.errors) {
+        while (next < result.good_starts.size() && result.good_starts[next] < error) next++;
+        if (next == result.good_starts.size()) break;
+        resync.push_back(result.good_starts[next] - error);
+    }
+    if (!resync.empty()) {
+        std::sort(resync.begin(), resync.end());
+        double sum = 0;
+        for (size_t bytes : resync) sum += bytes;
+        printf("bytes to resync: mean %.1f, p50 %zu, p95 %zu, max %zu (one frame is %u bytes)\n", sum / resync.size(),
+               resync[resync.size() / 2], resync[resync.size() * 95 / 100], resync.back(), REPORT_SIZE);
+    }
+
+    if (options.repeat == 0) return 0;
+    auto start = std::chrono::steady_clock::now();
+    uint32_t checksum = 0;
+    for (uint32_t i = 0; i < options.repeat; i++) {
+        checksum += parse(stream, originals, options.gap_abort, false).good;
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double bytes = (double) stream.bytes.size() * options.repeat;
+    printf("throughput %.1f MB/s, %.1f ns/byte (%u good frames over %u passes)\n", bytes / elapsed / 1e6,
+           elapsed * 1e9 / bytes, checksum, options.repeat);
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include "sim_unit.h"
+
+#include <cstring>
+
+namespace esphome {
+namespace sinclair_ac {
+
+static const uint32_t DRIFT_STEP_MS = 60000;
+
+SimUnit::SimUnit() : state{} {
+    this->state.power = true;
+    this->state.mode = CNT::protocol::REPORT_MODE_COOL;
+    this->state.target_temperature = 24;
+    this->state.current_temperature = 260;
+    this->state.display_on = true;
+}
+
+void SimUnit::build_report(uint8_t *frame) const {
+    memset(frame, 0, REPORT_SIZE);
+    frame[0] = CNT::protocol::SYNC;
+    frame[1] = CNT::protocol::SYNC;
+    frame[2] = REPORT_LEN;
+    frame[3] = CNT::protocol::CMD_IN_UNIT_REPORT;
+
+    uint8_t *payload = frame + CNT::protocol::PAYLOAD_OFFSET;
+    CNT::FieldValues values;
+    CNT::unit_state_to_fields(this->state, values);
+    CNT::encode_fields(values, payload, REPORT_SIZE - CNT::protocol::PAYLOAD_OFFSET - 1);
+    /* the room temperature is read-only, so encode_fields leaves it out */
+    payload[CNT::protocol::REPORT_TEMP_ACT_BYTE] = (uint8_t) (this->state.current_temperature *
+                                                             CNT::protocol::REPORT_TEMP_ACT_DIV / 10 +
+                                                             CNT::protocol::REPORT_TEMP_ACT_OFF);
+    frame[REPORT_SIZE - 1] = frame_checksum(frame, REPORT_SIZE);
+}
+
+static uint8_t frame_size(uint8_t type, uint8_t length) {
+    switch (type) {
+        case CNT::protocol::CMD_OUT_PARAMS_SET: return CNT::protocol::SET_FRAME_SIZE;
+        case CNT::protocol::CMD_OUT_MAC_REPORT: return CNT::protocol::MAC_REPORT_FRAME_SIZE;
+        case CNT::protocol::CMD_OUT_INIT_PARAMS: return CNT::protocol::INIT_PARAMS_FRAME_SIZE;
+        default: return length + FRAME_HEADER_LEN;
+    }
+}
+
+void SimUnit::feed(const uint8_t *data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        uint8_t c = data[i];
+        /* hunt for 7E 7E, then collect the frame */
+        if (this->rx_size_ < 2 && c != CNT::protocol::SYNC) {
+            this->rx_size_ = 0;
+            continue;
+        }
+        this->rx_[this->rx_size_++] = c;
+        if (this->rx_size_ <= FRAME_TYPE_BYTE) continue;
+
+        uint8_t size = frame_size(this->rx_[FRAME_TYPE_BYTE], this->rx_[2]);
+        if (size > DATA_MAX || size <= FRAME_TYPE_BYTE + 1) {
+            this->rx_size_ = 0;
+            continue;
+        }
+        if (this->rx_size_ < size) continue;
+        this->take_frame(this->rx_, size);
+        this->rx_size_ = 0;
+    }
+}
+
+void SimUnit::take_frame(const uint8_t *frame, uint8_t size) {
+    if (frame_checksum(frame, size) != frame[size - 1]) {
+        this->bad_frames++;
+        return;
+    }
+    switch (frame[FRAME_TYPE_BYTE]) {
+        case CNT::protocol::CMD_OUT_PARAMS_SET: {
+            /* decode_fields reads report positions, the SET payload is shorter */
+            uint8_t payload[DATA_MAX] = {};
+            memcpy(payload, frame + CNT::protocol::PAYLOAD_OFFSET, size - CNT::protocol::PAYLOAD_OFFSET - 1);
+            CNT::FieldValues values;
+            CNT::decode_fields(payload, values);
+            int16_t current = this->state.current_temperature;
+            CNT::unit_state_from_fields(values, &this->state);
+            this->state.current_temperature = current;
+            this->sets++;
+            break;
+        }
+        case CNT::protocol::CMD_OUT_MAC_REPORT: this->mac_reports++; break;
+        case CNT::protocol::CMD_OUT_INIT_PARAMS: this->init_params++; break;
+        default: break;
+    }
+}
+
+void SimUnit::advance(uint32_t elapsed_ms) {
+    this->drift_ms_ += elapsed_ms;
+    while (this->drift_ms_ >= DRIFT_STEP_MS) {
+        this->drift_ms_ -= DRIFT_STEP_MS;
+        if (!this->state.power) continue;
+        int16_t target = this->state.target_temperature * 10;
+        int16_t &current = this->state.current_temperature;
+        bool cooling = this->state.mode == CNT::protocol::REPORT_MODE_COOL || this->state.mode == CNT::protocol::REPORT_MODE_AUTO;
+        bool heating = this->state.mode == CNT::protocol::REPORT_MODE_HEAT || this->state.mode == CNT::protocol::REPORT_MODE_AUTO;
+        if (cooling && current > target) current -= 5;
+        else if (heating && current < target) current += 5;
+    }
+}
+
+}  // namespace sinclair_ac
+}  // namespace esphome
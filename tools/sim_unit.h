@@ -0,0 +1,46 @@
+// Simulated indoor unit for host builds: sends 0x31 unit reports and takes the frames a module sends.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esppac_cnt_protocol.h"
+#include "esppac_frame.h"
+
+namespace esphome {
+namespace sinclair_ac {
+
+class SimUnit {
+    public:
+        static const uint8_t REPORT_LEN = 0x2F;  /* type, 45 payload bytes, checksum */
+        static const uint8_t REPORT_SIZE = REPORT_LEN + FRAME_HEADER_LEN;
+
+        SimUnit();
+
+        /* Unit report of the current state into frame, which must hold REPORT_SIZE bytes */
+        void build_report(uint8_t *frame) const;
+
+        /* Bytes sent by the module. SET frames are applied to the state, except the room temperature, MAC
+           reports and initial parameters are counted. SET frames are one byte shorter than their length byte
+           claims, so frames are taken by the size their type implies, not by the length byte. */
+        void feed(const uint8_t *data, size_t length);
+
+        /* Moves the room temperature towards the set point while running, 0.5 degrees per minute */
+        void advance(uint32_t elapsed_ms);
+
+        CNT::UnitState state;
+        uint32_t sets = 0;          /* SET frames applied */
+        uint32_t mac_reports = 0;
+        uint32_t init_params = 0;
+        uint32_t bad_frames = 0;    /* frames of a known type with a wrong checksum */
+
+    protected:
+        uint8_t rx_[DATA_MAX];
+        uint8_t rx_size_ = 0;
+        uint32_t drift_ms_ = 0;
+
+        void take_frame(const uint8_t *frame, uint8_t size);
+};
+
+}  // namespace sinclair_ac
+}  // namespace esphome
@@ -0,0 +1,471 @@
+// Drives many AC units from one Linux process, one single-threaded epoll loop for all of them.
+//
+// Built by the CMakeLists.txt in the repository root:
+//   cmake -S . -B build && cmake --build build
+//
+// Usage:
+//   sinclair_gateway <tty> [<tty> ...]
+//   sinclair_gateway --load <n[,n...]> [-d seconds] [-p report period ms] [-c command period ms]
+//
+// Gateway mode opens every tty at 4800 8E1 and runs one CNT::UnitLink per device, the link engine of the
+// ESPHome component, with the same parser and turn rules: a frame is only sent in the gap right after a
+// received frame, one frame per turn, the handshake goes out once the unit talks and commands wait for it.
+// Each unit gets the locally administered MAC address 02:00:00:00:00:<unit index> for the handshake.
+// Commands are read from stdin, one per line:
+//   <unit|all> power <on|off>
+//   <unit|all> mode <auto|cool|dry|fan|heat>
+//   <unit|all> temp <16..30>
+//   <unit|all> fan <0..4>
+// State changes reported by the units are printed to stdout.
+//
+// Load mode creates n pty pairs per run, a simulated unit on the master side of each and a gateway
+// unit on the slave side, and sends every unit a new target temperature every command period. Each
+// run prints frames per second and the command latency up to the confirming report.
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "esppac_cnt_link.h"
+#include "esppac_cnt_protocol.h"
+#include "esppac_frame.h"
+#include "esppac_stats.h"
+#include "sim_unit.h"
+
+using namespace esphome::sinclair_ac;
+
+namespace {
+
+const uint32_t TICK_MS = 5;
+
+uint32_t now_ms() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t) (ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+bool write_all(int fd, const uint8_t *data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            return false;
+        }
+        data += written;
+        length -= written;
+    }
+    return true;
+}
+
+bool set_raw(int fd, bool serial) {
+    termios tio;
+    if (tcgetattr(fd, &tio) != 0) return false;
+    cfmakeraw(&tio);
+    if (serial) {
+        cfsetispeed(&tio, B4800);
+        cfsetospeed(&tio, B4800);
+        tio.c_cflag |= PARENB | CLOCAL | CREAD;
+        tio.c_cflag &= ~(PARODD | CSTOPB);
+    }
+    return tcsetattr(fd, TCSANOW, &tio) == 0;
+}
+
+/* Gateway side of one unit, SinclairACCNT without the Home Assistant parts */
+struct Unit {
+    int fd = -1;
+    std::string name;
+    FrameParser parser;
+    CNT::UnitLink link;
+
+    uint32_t last_byte = 0;
+    uint32_t last_frame = 0;
+    bool wait_response = false;
+
+    CNT::UnitState reported{};
+    bool have_report = false;
+
+    uint32_t frames = 0;
+    uint32_t reports = 0;
+    uint32_t errors = 0;
+};
+
+/* Simulated indoor unit on the master side of a pty */
+struct SimPort {
+    int fd = -1;
+    SimUnit unit;
+    uint32_t next_report = 0;
+};
+
+struct Gateway {
+    int epoll_fd = -1;
+    std::vector<std::unique_ptr<Unit>> units;
+    std::vector<std::unique_ptr<SimPort>> sims;
+    uint32_t report_period = 300;
+    bool verbose = true;
+};
+
+/* epoll user data: low bit marks simulated units, the rest is the index */
+uint64_t unit_key(size_t index) { return index << 1; }
+uint64_t sim_key(size_t index) { return (index << 1) | 1; }
+
+void print_report(const Unit &unit, const CNT::UnitState &state) {
+    printf("%s: power=%d mode=%u fan=%u set=%u act=%.1f\n", unit.name.c_str(), state.power, state.mode,
+           state.fan, state.target_temperature, state.current_temperature / 10.0);
+    fflush(stdout);
+}
+
+void print_events(const Gateway &gateway, Unit *unit) {
+    uint16_t events = unit->link.take_events();
+    if (!gateway.verbose || events == 0) return;
+    const char *name = unit->name.c_str();
+    if (events & CNT::link_events::LINK_LOST) fprintf(stderr, "%s: no data, holding commands\n", name);
+    if (events & CNT::link_events::LINK_READY) fprintf(stderr, "%s: link ready\n", name);
+    if (events & CNT::link_events::SET_FAILED) fprintf(stderr, "%s: SET not confirmed, giving up\n", name);
+}
+
+/* one frame per turn, in the gap after a received frame, as SinclairAC::can_transmit() */
+void transmit(Gateway *gateway, Unit *unit, uint32_t now) {
+    if (unit->wait_response || unit->parser.in_frame() || now - unit->last_frame >= TX_WINDOW_MS) return;
+
+    uint8_t packet[CNT::LINK_FRAME_MAX];
+    uint8_t size = unit->link.transmit(now, packet);
+    print_events(*gateway, unit);
+    if (size == 0) return;
+    if (!write_all(unit->fd, packet, size)) {
+        fprintf(stderr, "%s: write failed: %s\n", unit->name.c_str(), strerror(errno));
+        return;
+    }
+    unit->wait_response = true;
+}
+
+void handle_report(Gateway *gateway, Unit *unit, const FrameView &frame, uint32_t now) {
+    CNT::UnitState state{};
+    if (unit->link.on_report(frame, now, &state) != CNT::DecodeResult::Ok) {
+        unit->errors++;
+        return;
+    }
+    unit->reports++;
+    print_events(*gateway, unit);
+    bool changed = !unit->have_report || memcmp(&state, &unit->reported, sizeof(state)) != 0;
+    unit->reported = state;
+    unit->have_report = true;
+    if (changed && gateway->verbose) print_report(*unit, state);
+}
+
+void read_unit(Gateway *gateway, Unit *unit) {
+    uint8_t buffer[256];
+    for (;;) {
+        ssize_t count = read(unit->fd, buffer, sizeof(buffer));
+        if (count <= 0) break;
+        uint32_t now = now_ms();
+        unit->last_byte = now;
+        for (ssize_t i = 0; i < count; i++) {
+            if (!unit->parser.feed(buffer[i])) continue;
+            const FrameView frame = unit->parser.frame();
+            unit->frames++;
+            unit->last_frame = now;
+            unit->wait_response = false;
+            if (frame.type() == CNT::protocol::CMD_IN_UNIT_REPORT) handle_report(gateway, unit, frame, now);
+            unit->parser.reset();
+        }
+    }
+    transmit(gateway, unit, now_ms());
+}
+
+void send_sim_report(SimPort *sim) {
+    uint8_t packet[SimUnit::REPORT_SIZE];
+    sim->unit.build_report(packet);
+    write_all(sim->fd, packet, sizeof(packet));
+}
+
+void read_sim(SimPort *sim) {
+    uint8_t buffer[256];
+    for (;;) {
+        ssize_t count = read(sim->fd, buffer, sizeof(buffer));
+        if (count <= 0) break;
+        sim->unit.feed(buffer, count);
+    }
+}
+
+void tick(Gateway *gateway) {
+    uint32_t now = now_ms();
+    for (auto &sim : gateway->sims) {
+        if ((int32_t) (now - sim->next_report) < 0) continue;
+        send_sim_report(sim.get());
+        sim->next_report = now + gateway->report_period;
+    }
+    for (auto &unit : gateway->units) {
+        /* a frame that lost bytes would otherwise swallow the start of the next one */
+        if (unit->parser.in_frame() && now - unit->last_byte > READ_TIMEOUT) unit->parser.abort();
+        unit->link.check(now, unit->last_frame);
+        transmit(gateway, unit.get(), now);
+    }
+}
+
+bool watch(Gateway *gateway, int fd, uint64_t key) {
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = key;
+    return epoll_ctl(gateway->epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+Unit *add_unit(Gateway *gateway, int fd, const std::string &name) {
+    auto unit = std::make_unique<Unit>();
+    unit->fd = fd;
+    unit->name = name;
+    unit->parser.accept(CNT::protocol::CMD_IN_UNIT_REPORT);
+    const uint8_t mac[6] = {0x02, 0, 0, 0, 0, (uint8_t) gateway->units.size()};
+    unit->link.set_mac(mac);
+    watch(gateway, fd, unit_key(gateway->units.size()));
+    gateway->units.push_back(std::move(unit));
+    return gateway->units.back().get();
+}
+
+/* hands one stdin command to the unit's link, which merges it into the SET frame of its next turn */
+bool apply_command(Unit *unit, const char *what, const char *value) {
+    /* fields the command does not set keep what is pending, or else what the unit reported */
+    CNT::UnitState wanted = unit->reported;
+    CNT::copy_fields(&wanted, unit->link.requested(), unit->link.pending_fields());
+    uint16_t fields;
+    if (strcmp(what, "power") == 0) {
+        wanted.power = strcmp(value, "on") == 0;
+        fields = CNT::update_fields::MODE;
+    } else if (strcmp(what, "mode") == 0) {
+        static const struct { const char *name; uint8_t mode; } MODES[] = {
+            {"auto", CNT::protocol::REPORT_MODE_AUTO}, {"cool", CNT::protocol::REPORT_MODE_COOL},
+            {"dry", CNT::protocol::REPORT_MODE_DRY},   {"fan", CNT::protocol::REPORT_MODE_FAN},
+            {"heat", CNT::protocol::REPORT_MODE_HEAT},
+        };
+        bool found = false;
+        for (const auto &mode : MODES) {
+            if (strcmp(mode.name, value) == 0) {
+                wanted.mode = mode.mode;
+                wanted.power = true;
+                found = true;
+            }
+        }
+        if (!found) return false;
+        fields = CNT::update_fields::MODE;
+    } else if (strcmp(what, "temp") == 0) {
+        int temp = atoi(value);
+        if (temp < 16 || temp > 30) return false;
+        wanted.target_temperature = (uint8_t) temp;
+        fields = CNT::update_fields::TARGET_TEMP;
+    } else if (strcmp(what, "fan") == 0) {
+        int fan = atoi(value);
+        if (fan < CNT::FAN_SPEED_AUTO || fan > CNT::FAN_SPEED_TURBO) return false;
+        wanted.fan = (uint8_t) fan;
+        fields = CNT::update_fields::FAN;
+    } else {
+        return false;
+    }
+    unit->link.request(fields, wanted);
+    return true;
+}
+
+void read_stdin(Gateway *gateway) {
+    static std::string pending;
+    char buffer[256];
+    ssize_t count = read(STDIN_FILENO, buffer, sizeof(buffer));
+    if (count <= 0) return;
+    pending.append(buffer, count);
+    size_t end;
+    while ((end = pending.find('\n')) != std::string::npos) {
+        std::string line = pending.substr(0, end);
+        pending.erase(0, end + 1);
+        char target[32], what[16], value[16];
+        if (sscanf(line.c_str(), "%31s %15s %15s", target, what, value) != 3) {
+            if (!line.empty()) fprintf(stderr, "usage: <unit|all> <power|mode|temp|fan> <value>\n");
+            continue;
+        }
+        bool all = strcmp(target, "all") == 0;
+        size_t index = all ? 0 : strtoul(target, nullptr, 10);
+        if (!all && index >= gateway->units.size()) {
+            fprintf(stderr, "no unit %s\n", target);
+            continue;
+        }
+        for (size_t i = 0; i < gateway->units.size(); i++) {
+            if ((all || i == index) && !apply_command(gateway->units[i].get(), what, value)) {
+                fprintf(stderr, "bad command: %s\n", line.c_str());
+                break;
+            }
+        }
+    }
+}
+
+/* runs the event loop until duration_ms has passed, 0 runs forever */
+void run(Gateway *gateway, int timer_fd, bool with_stdin, uint32_t duration_ms,
+         uint32_t command_period, uint32_t *commands) {
+    const uint64_t TIMER_KEY = UINT64_MAX;
+    const uint64_t STDIN_KEY = UINT64_MAX - 1;
+    watch(gateway, timer_fd, TIMER_KEY);
+    if (with_stdin) watch(gateway, STDIN_FILENO, STDIN_KEY);
+
+    uint32_t start = now_ms();
+    uint32_t next_command = start + command_period;
+    uint8_t temp = 20;
+    epoll_event events[64];
+    for (;;) {
+        int count = epoll_wait(gateway->epoll_fd, events, 64, -1);
+        if (count < 0 && errno != EINTR) break;
+        for (int i = 0; i < count; i++) {
+            uint64_t key = events[i].data.u64;
+            if (key == TIMER_KEY) {
+                uint64_t expirations;
+                if (read(timer_fd, &expirations, sizeof(expirations)) < 0) continue;
+                tick(gateway);
+            } else if (key == STDIN_KEY) {
+                read_stdin(gateway);
+            } else if (key & 1) {
+                read_sim(gateway->sims[key >> 1].get());
+            } else {
+                read_unit(gateway, gateway->units[key >> 1].get());
+            }
+        }
+        uint32_t now = now_ms();
+        if (command_period > 0 && (int32_t) (now - next_command) >= 0) {
+            temp = temp == 20 ? 24 : 20;
+            for (auto &unit : gateway->units) {
+                if (!unit->link.ready()) continue;
+                apply_command(unit.get(), "temp", std::to_string(temp).c_str());
+                (*commands)++;
+            }
+            next_command = now + command_period;
+        }
+        if (duration_ms > 0 && now - start >= duration_ms) break;
+    }
+}
+
+int make_timer() {
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    itimerspec spec{};
+    spec.it_interval.tv_nsec = TICK_MS * 1000000;
+    spec.it_value.tv_nsec = TICK_MS * 1000000;
+    timerfd_settime(fd, 0, &spec, nullptr);
+    return fd;
+}
+
+int load_test(const char *sizes, uint32_t duration_ms, uint32_t report_period, uint32_t command_period) {
+    printf("%6s %10s %10s %8s %8s %8s %8s %8s\n", "units", "frames/s", "commands", "p50 ms", "p95 ms", "max ms",
+           "failed", "errors");
+    for (const char *p = sizes; *p != '\0';) {
+        char *end;
+        unsigned long n = strtoul(p, &end, 10);
+        p = *end == ',' ? end + 1 : end;
+        if (n == 0) continue;
+
+        Gateway gateway;
+        gateway.epoll_fd = epoll_create1(0);
+        gateway.report_period = report_period;
+        gateway.verbose = false;
+        bool ok = true;
+        for (unsigned long i = 0; i < n && ok; i++) {
+            int master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+            if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+                perror("posix_openpt");
+                ok = false;
+                break;
+            }
+            int slave = open(ptsname(master), O_RDWR | O_NOCTTY | O_NONBLOCK);
+            if (slave < 0 || !set_raw(slave, false)) {
+                perror("pty");
+                ok = false;
+                break;
+            }
+            auto sim = std::make_unique<SimPort>();
+            sim->fd = master;
+            sim->unit.state.target_temperature = 22;
+            sim->unit.state.current_temperature = 240;
+            /* spread the reports over the period like independent units would */
+            sim->next_report = now_ms() + (uint32_t) (i * report_period / n);
+            watch(&gateway, master, sim_key(gateway.sims.size()));
+            gateway.sims.push_back(std::move(sim));
+            add_unit(&gateway, slave, "unit" + std::to_string(i));
+        }
+        if (!ok) return 1;
+
+        int timer_fd = make_timer();
+        uint32_t commands = 0;
+        uint32_t start = now_ms();
+        run(&gateway, timer_fd, false, duration_ms, command_period, &commands);
+        double elapsed = (now_ms() - start) / 1000.0;
+
+        uint32_t frames = 0, failures = 0, errors = 0, max = 0;
+        std::vector<uint32_t> p50, p95;
+        for (auto &unit : gateway.units) {
+            frames += unit->frames;
+            failures += unit->link.failures_total();
+            errors += unit->errors;
+            const LatencyHistogram &latency = unit->link.latency();
+            if (latency.max() > max) max = latency.max();
+            p50.push_back(latency.percentile(50));
+            p95.push_back(latency.percentile(95));
+        }
+        /* worst unit, the histograms only resolve to their bucket bounds anyway */
+        uint32_t worst50 = 0, worst95 = 0;
+        for (size_t i = 0; i < p50.size(); i++) {
+            if (p50[i] > worst50) worst50 = p50[i];
+            if (p95[i] > worst95) worst95 = p95[i];
+        }
+        printf("%6lu %10.0f %10u %8u %8u %8u %8u %8u\n", n, frames / elapsed, commands, worst50, worst95, max,
+               failures, errors);
+        fflush(stdout);
+
+        close(timer_fd);
+        for (auto &unit : gateway.units) close(unit->fd);
+        for (auto &sim : gateway.sims) close(sim->fd);
+        close(gateway.epoll_fd);
+    }
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    const char *load = nullptr;
+    uint32_t duration_ms = 10000;
+    uint32_t report_period = 300;
+    uint32_t command_period = 2000;
+    std::vector<const char *> devices;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--load") == 0 && i + 1 < argc) load = argv[++i];
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) duration_ms = strtoul(argv[++i], nullptr, 10) * 1000;
+        else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) report_period = strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) command_period = strtoul(argv[++i], nullptr, 10);
+        else devices.push_back(argv[i]);
+    }
+    if (load != nullptr) return load_test(load, duration_ms, report_period, command_period);
+    if (devices.empty()) {
+        fprintf(stderr, "usage: %s <tty> [<tty> ...]\n"
+                        "       %s --load <n[,n...]> [-d seconds] [-p report period ms] [-c command period ms]\n",
+                argv[0], argv[0]);
+        return 2;
+    }
+
+    Gateway gateway;
+    gateway.epoll_fd = epoll_create1(0);
+    for (const char *device : devices) {
+        int fd = open(device, O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if (fd < 0 || !set_raw(fd, true)) {
+            perror(device);
+            return 1;
+        }
+        Unit *unit = add_unit(&gateway, fd, std::to_string(gateway.units.size()));
+        fprintf(stderr, "unit %s on %s\n", unit->name.c_str(), device);
+    }
+    int timer_fd = make_timer();
+    uint32_t commands = 0;
+    run(&gateway, timer_fd, true, 0, 0, &commands);
+    return 0;
+}
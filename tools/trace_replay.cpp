@@ -0,0 +1,196 @@
+// Replays frames captured with dump_trace() through the protocol core on a Linux host.
+//
+// Built by the CMakeLists.txt in the repository root:
+//   cmake -S . -B build && cmake --build build
+//
+// Usage:
+//   trace_replay [-q] [-r repeat] <log file | ->
+//
+// The input is an ESPHome log. Lines containing "TRACE <ms> <RX|TX> <hex>" (dump_trace() output) and
+// the older VERBOSE "RX: 7E.7E...." / "TX: ..." lines are picked up, everything else is ignored.
+// RX frames are concatenated into one byte stream and fed through FrameParser byte by byte, unit
+// reports are decoded the same way the component does it. A partial frame is dropped where the
+// trace shows a pause longer than READ_TIMEOUT, like the component does. With -r the stream is replayed repeatedly
+// to measure parser and decoder throughput.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "esppac_cnt_protocol.h"
+#include "esppac_frame.h"
+
+using namespace esphome::sinclair_ac;
+
+namespace {
+
+/* same as READ_TIMEOUT in esppac.h, which pulls in ESPHome */
+const unsigned long READ_TIMEOUT_MS = 20;
+
+struct Capture {
+    std::vector<uint8_t> rx_stream;
+    std::vector<size_t> rx_gaps;  /* stream offsets preceded by a pause long enough to abort a partial frame */
+    unsigned long last_rx_time = 0;
+    std::vector<std::vector<uint8_t>> tx_frames;
+};
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/* parses hex pairs, optionally separated by '.', up to the first character that is neither */
+std::vector<uint8_t> parse_hex(const char *text) {
+    std::vector<uint8_t> bytes;
+    while (*text != '\0') {
+        if (*text == '.') {
+            text++;
+            continue;
+        }
+        int high = hex_value(text[0]);
+        int low = high < 0 ? -1 : hex_value(text[1]);
+        if (low < 0) break;
+        bytes.push_back((uint8_t) ((high << 4) | low));
+        text += 2;
+    }
+    return bytes;
+}
+
+/* time is the trace timestamp, or 0 for the older log lines where every line was a separate read */
+void add_frame(Capture *capture, bool outgoing, const std::vector<uint8_t> &bytes, unsigned long time) {
+    if (bytes.empty()) return;
+    if (outgoing) {
+        capture->tx_frames.push_back(bytes);
+    } else {
+        if (time == 0 || time - capture->last_rx_time > READ_TIMEOUT_MS) {
+            capture->rx_gaps.push_back(capture->rx_stream.size());
+        }
+        capture->last_rx_time = time;
+        capture->rx_stream.insert(capture->rx_stream.end(), bytes.begin(), bytes.end());
+    }
+}
+
+bool load(FILE *input, Capture *capture) {
+    char line[2048];
+    while (fgets(line, sizeof(line), input) != nullptr) {
+        const char *trace = strstr(line, "TRACE ");
+        if (trace != nullptr) {
+            unsigned long time;
+            char dir[3];
+            int consumed = 0;
+            if (sscanf(trace, "TRACE %lu %2s %n", &time, dir, &consumed) >= 2 && consumed > 0) {
+                add_frame(capture, strcmp(dir, "TX") == 0, parse_hex(trace + consumed), time);
+            }
+            continue;
+        }
+        const char *rx = strstr(line, "RX: ");
+        const char *tx = strstr(line, "TX: ");
+        if (rx != nullptr) add_frame(capture, false, parse_hex(rx + 4), 0);
+        else if (tx != nullptr) add_frame(capture, true, parse_hex(tx + 4), 0);
+    }
+    return true;
+}
+
+void print_state(const char *prefix, const CNT::UnitState &state) {
+    printf("%s power=%d mode=%u fan=%u set=%u act=%.1f hswing=%u vswing=%u disp=%d/%u F=%d plasma=%d sleep=%d xfan=%d save=%d\n",
+           prefix, state.power, state.mode, state.fan, state.target_temperature, state.current_temperature / 10.0,
+           state.hswing, state.vswing, state.display_on, state.display_mode, state.display_fahrenheit,
+           state.plasma, state.sleep, state.xfan, state.save);
+}
+
+/* one pass over the RX stream, returns the number of unit reports decoded */
+uint32_t replay(const Capture &capture, bool print, uint32_t *frames, uint32_t *errors) {
+    FrameParser parser;
+    uint32_t reports = 0;
+    size_t gap = 0;
+    for (size_t i = 0; i < capture.rx_stream.size(); i++) {
+        /* the component drops a partial frame when the line goes quiet, do the same at recorded pauses */
+        if (gap < capture.rx_gaps.size() && capture.rx_gaps[gap] == i) {
+            parser.abort();
+            gap++;
+        }
+        if (!parser.feed(capture.rx_stream[i])) continue;
+        const FrameView frame = parser.frame();
+        (*frames)++;
+        if (frame.type() == CNT::protocol::CMD_IN_UNIT_REPORT) {
+            CNT::UnitState state;
+            CNT::DecodeResult result = CNT::decode_unit_report(frame, &state);
+            if (result == CNT::DecodeResult::Ok) {
+                reports++;
+                if (print) print_state("RX 0x31", state);
+            } else {
+                (*errors)++;
+                if (print) printf("RX 0x31 decode error %d\n", (int) result);
+            }
+        } else if (print) {
+            printf("RX 0x%02X, %u bytes\n", frame.type(), frame.size);
+        }
+        parser.reset();
+    }
+    if (print && parser.stats().timeouts > 0) {
+        printf("%u partial frames dropped at pauses\n", parser.stats().timeouts);
+    }
+    return reports;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    bool quiet = false;
+    unsigned long repeat = 0;
+    const char *path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-q") == 0) quiet = true;
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) repeat = strtoul(argv[++i], nullptr, 10);
+        else path = argv[i];
+    }
+    if (path == nullptr) {
+        fprintf(stderr, "usage: %s [-q] [-r repeat] <log file | ->\n", argv[0]);
+        return 2;
+    }
+
+    FILE *input = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (input == nullptr) {
+        perror(path);
+        return 1;
+    }
+    Capture capture;
+    load(input, &capture);
+    if (input != stdin) fclose(input);
+
+    uint32_t frames = 0;
+    uint32_t errors = 0;
+    uint32_t reports = replay(capture, !quiet, &frames, &errors);
+    if (!quiet) {
+        for (const auto &tx : capture.tx_frames) {
+            if (tx.size() < CNT::protocol::SET_FRAME_SIZE) {
+                printf("TX 0x%02X, %zu bytes\n", tx.size() > FRAME_TYPE_BYTE ? tx[FRAME_TYPE_BYTE] : 0, tx.size());
+                continue;
+            }
+            CNT::FieldValues values;
+            CNT::UnitState state;
+            CNT::decode_fields(tx.data() + CNT::protocol::PAYLOAD_OFFSET, values);
+            CNT::unit_state_from_fields(values, &state);
+            print_state("TX SET", state);
+        }
+    }
+    printf("%zu RX bytes, %u frames, %u unit reports, %u decode errors, %zu TX frames\n",
+           capture.rx_stream.size(), frames, reports, errors, capture.tx_frames.size());
+
+    if (repeat == 0 || capture.rx_stream.empty()) return errors == 0 ? 0 : 1;
+
+    uint32_t bench_frames = 0;
+    uint32_t bench_errors = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < repeat; i++) replay(capture, false, &bench_frames, &bench_errors);
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double bytes = (double) capture.rx_stream.size() * repeat;
+    printf("replayed %lu times: %.1f MB/s, %.0f frames/s, %.1f ns/frame\n", repeat, bytes / elapsed / 1e6,
+           bench_frames / elapsed, elapsed * 1e9 / (bench_frames ? bench_frames : 1));
+    return errors == 0 ? 0 : 1;
+}
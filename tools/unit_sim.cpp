@@ -0,0 +1,109 @@
+// Simulated indoor unit on a pty, to run the gateway or anything else that talks CNT against on a Linux host.
+//
+// Built by the CMakeLists.txt in the repository root:
+//   cmake -S . -B build && cmake --build build
+//
+// Usage:
+//   unit_sim [-p report period ms] [-v]
+//
+// Opens a pty pair and prints the slave device, connect the module side there, e.g.
+//   sinclair_gateway /dev/pts/5
+// A 0x31 unit report goes out every report period. SET frames from the module are applied to the state
+// and echoed by the next report, MAC reports and initial parameters are counted. The room temperature
+// follows the set point slowly while the unit runs. With -v every state change is printed.
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "sim_unit.h"
+
+using namespace esphome::sinclair_ac;
+
+namespace {
+
+volatile sig_atomic_t stop = 0;
+
+uint32_t now_ms() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t) (ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+void print_state(const SimUnit &sim) {
+    const CNT::UnitState &state = sim.state;
+    printf("power=%d mode=%u fan=%u set=%u act=%.1f  (%u SET, %u MAC report, %u init params, %u bad)\n", state.power,
+           state.mode, state.fan, state.target_temperature, state.current_temperature / 10.0, sim.sets,
+           sim.mac_reports, sim.init_params, sim.bad_frames);
+    fflush(stdout);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    uint32_t report_period = 300;
+    bool verbose = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) report_period = strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "-v") == 0) verbose = true;
+        else {
+            fprintf(stderr, "usage: %s [-p report period ms] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        perror("posix_openpt");
+        return 1;
+    }
+    termios tio;
+    if (tcgetattr(master, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(master, TCSANOW, &tio);
+    }
+    printf("simulated unit on %s\n", ptsname(master));
+    fflush(stdout);
+    signal(SIGINT, [](int) { stop = 1; });
+
+    SimUnit sim;
+    uint32_t last = now_ms();
+    uint32_t next_report = last;
+    uint32_t sets = 0;
+    while (!stop) {
+        uint32_t now = now_ms();
+        int32_t wait = (int32_t) (next_report - now);
+        pollfd fd{master, POLLIN, 0};
+        if (poll(&fd, 1, wait > 0 ? wait : 0) > 0 && (fd.revents & POLLIN)) {
+            uint8_t buffer[256];
+            ssize_t count = read(master, buffer, sizeof(buffer));
+            if (count > 0) sim.feed(buffer, count);
+        }
+
+        now = now_ms();
+        sim.advance(now - last);
+        last = now;
+        if (verbose && sim.sets != sets) print_state(sim);
+        sets = sim.sets;
+        if ((int32_t) (now - next_report) < 0) continue;
+
+        uint8_t report[SimUnit::REPORT_SIZE];
+        sim.build_report(report);
+        /* without a peer on the slave side the write fails, the unit keeps reporting anyway */
+        if (write(master, report, sizeof(report)) < 0 && errno != EAGAIN && errno != EIO) {
+            perror("write");
+            return 1;
+        }
+        next_report = now + report_period;
+    }
+    print_state(sim);
+    return 0;
+}